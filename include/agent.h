@@ -6,6 +6,10 @@
 #include <string>
 #include <memory>
 
+class CheckpointWriter;
+class MappedCheckpoint;
+class Normalizer;
+
 /**
  * Abstract base class for all RL agents.
  * Defines the interface that all learning algorithms must implement.
@@ -18,8 +22,16 @@ public:
     virtual Action act(const State& state) = 0;
     virtual void learn(const Experience& experience) = 0;
     
+    // Actions for several states at once (used by InferenceBroker). Agents
+    // with a batched forward pass override this; the default calls act().
+    virtual void actBatch(const State* states, size_t count, Action* actions) {
+        for (size_t i = 0; i < count; ++i) {
+            actions[i] = act(states[i]);
+        }
+    }
+    
     // Episode-based learning (for algorithms that need full trajectories)
-    virtual void learn(const std::vector<Experience>& trajectory) {
+    virtual void learn(const Trajectory& trajectory) {
         // Default implementation: learn from each experience individually
         for (const auto& exp : trajectory) {
             learn(exp);
@@ -30,9 +42,16 @@ public:
     virtual void setTrainingMode(bool training) { training_mode_ = training; }
     virtual bool isTraining() const { return training_mode_; }
     
-    // Model persistence
-    virtual void saveModel(const std::string& filepath) {}
-    virtual void loadModel(const std::string& filepath) {}
+    // Model persistence (atomic checkpoint file, see checkpoint.h)
+    virtual void saveModel(const std::string& filepath) const;
+    virtual void loadModel(const std::string& filepath);
+    
+    // Load from an already mapped checkpoint; agents may keep zero-copy views into it
+    virtual void loadModel(const std::shared_ptr<const MappedCheckpoint>& checkpoint);
+    
+    // Observation/reward statistics saved and loaded together with the model
+    void setNormalizer(std::shared_ptr<Normalizer> normalizer) { normalizer_ = std::move(normalizer); }
+    Normalizer* getNormalizer() const { return normalizer_.get(); }
     
     // Agent metadata
     virtual std::string getName() const = 0;
@@ -41,6 +60,9 @@ public:
     // Reset agent state (for episodic algorithms)
     virtual void reset() {}
     
+    // Independent copy for parallel rollouts/evaluation (nullptr if unsupported)
+    virtual std::unique_ptr<Agent> clone() const { return nullptr; }
+    
     // Get learning statistics
     virtual std::vector<std::pair<std::string, double>> getStats() const {
         return {};
@@ -48,6 +70,11 @@ public:
 
 protected:
     bool training_mode_ = true;
+    std::shared_ptr<Normalizer> normalizer_;
+    
+    // Checkpoint hooks: add/restore parameter, optimizer and RNG blobs
+    virtual void saveState(CheckpointWriter& writer) const {}
+    virtual void loadState(const std::shared_ptr<const MappedCheckpoint>& checkpoint) {}
 };
 
 #endif // AGENT_H
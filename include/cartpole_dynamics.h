@@ -0,0 +1,118 @@
+#ifndef CARTPOLE_DYNAMICS_H
+#define CARTPOLE_DYNAMICS_H
+
+#include "dual.h"
+#include <algorithm>
+#include <cmath>
+#include "mujoco/mujoco.h"
+
+/**
+ * Physical constants of a single-pole cart-pole, read from a compiled
+ * model (nominal or patched by DomainRandomizer).
+ */
+struct CartPoleParameters {
+    double cart_mass;          // Body mass of the cart alone
+    double pole_mass;          // Pole capsule plus tip sphere
+    double com_x;              // Pole centre of mass in the pole body frame
+    double com_z;
+    double pole_inertia;       // About the hinge axis through the centre of mass
+    double gravity;            // Downward acceleration
+    double timestep;
+    double gear;
+    double ctrl_min;
+    double ctrl_max;
+    bool ctrl_limited;
+    double damping[2];         // Slider, hinge
+    double armature[2];
+    double qpos0[2];           // Reference positions (hinge ref = 3.14159 in cartpole.xml)
+};
+
+/**
+ * Closed-form dynamics of mujoco/cartpole.xml, templated on the scalar type.
+ *
+ * With T = double, step() reproduces one mj_step of the Euler integrator up
+ * to rounding; with T = Dual<N> it also propagates N directional
+ * derivatives, giving A/B Jacobians and gradients of whole episodes through
+ * the simulator without finite differences.
+ *
+ * States use the observation layout [x, x_dot, theta, theta_dot] of
+ * CartPoleEnv (theta is qpos of the hinge, so the pole is in its XML
+ * pose at theta = qpos0). reward() matches CartPoleEnv::computeReward.
+ */
+class CartPoleDynamics {
+public:
+    explicit CartPoleDynamics(const mjModel* model);
+    explicit CartPoleDynamics(const CartPoleParameters& parameters) : p_(parameters) {}
+
+    static CartPoleParameters parametersFromModel(const mjModel* model);
+    const CartPoleParameters& parameters() const { return p_; }
+
+    // One semi-implicit Euler step: v += h * qacc(q, v, u); q += h * v
+    template <typename T>
+    void step(const T state[4], const T& ctrl, T next[4]) const {
+        using std::cos;
+        using std::sin;
+
+        // Actuator force, clamped to ctrlrange like MuJoCo (zero gradient when saturated)
+        T u = ctrl;
+        if (p_.ctrl_limited) {
+            if (primal(u) < p_.ctrl_min) {
+                u = T(p_.ctrl_min);
+            } else if (primal(u) > p_.ctrl_max) {
+                u = T(p_.ctrl_max);
+            }
+        }
+
+        // Pole rotation relative to its XML pose, and centre-of-mass derivatives
+        const T phi = state[2] - p_.qpos0[1];
+        const T c = cos(phi);
+        const T s = sin(phi);
+        const T dxc = c * p_.com_z - s * p_.com_x;      // d(com_x_world)/d(phi)
+        const T dzc = -(c * p_.com_x) - s * p_.com_z;   // d(com_z_world)/d(phi)
+        const T& x_dot = state[1];
+        const T& phi_dot = state[3];
+
+        // Mass matrix with armature and the implicit damping term h*D of mj_Euler
+        const double h = p_.timestep;
+        const double m = p_.pole_mass;
+        const double length_sq = p_.com_x * p_.com_x + p_.com_z * p_.com_z;
+        const double m11 = p_.cart_mass + m + p_.armature[0] + h * p_.damping[0];
+        const double m22 = p_.pole_inertia + m * length_sq + p_.armature[1] + h * p_.damping[1];
+        const T m12 = m * dxc;
+
+        // Generalized forces: actuator, centrifugal, gravity and damping
+        const T f1 = p_.gear * u - m * dzc * phi_dot * phi_dot - p_.damping[0] * x_dot;
+        const T f2 = -(m * p_.gravity) * dzc - p_.damping[1] * phi_dot;
+
+        const T det = m11 * m22 - m12 * m12;
+        const T x_acc = (m22 * f1 - m12 * f2) / det;
+        const T phi_acc = (m11 * f2 - m12 * f1) / det;
+
+        next[1] = x_dot + h * x_acc;
+        next[3] = phi_dot + h * phi_acc;
+        next[0] = state[0] + h * next[1];
+        next[2] = state[2] + h * next[3];
+    }
+
+    // cos(theta) + 1 of the new state, as in CartPoleEnv::computeReward
+    template <typename T>
+    T reward(const T state[4]) const {
+        using std::cos;
+        return cos(state[2]) + 1.0;
+    }
+
+    // A = d(next)/d(state) (row-major 4x4) and B = d(next)/d(ctrl) at one point
+    void jacobians(const double state[4], double ctrl, double A[16], double B[4]) const;
+
+    // Total reward of the linear policy u = w[0..3] . state + w[4] over `steps`
+    // steps from `initial`, and its gradient with respect to the five weights
+    double linearPolicyReturn(const double weights[5], const double initial[4], int steps,
+                              double gradient[5]) const;
+    // Same return without derivatives
+    double linearPolicyReturn(const double weights[5], const double initial[4], int steps) const;
+
+private:
+    CartPoleParameters p_;
+};
+
+#endif // CARTPOLE_DYNAMICS_H
@@ -6,6 +6,10 @@
 #include <random>
 #include <memory>
 #include "environment.h"
+#include "domain_randomizer.h"
+#include "initial_state_pool.h"
+#include "observation_spec.h"
+#include "trajectory_recorder.h"
 #include "mujoco/mujoco.h"
 
 // Forward declaration to avoid including GLFW in header
@@ -15,8 +19,14 @@ class CartPoleEnv : public Environment {
 public:
     // Constructor and destructor
     CartPoleEnv(const std::string& model_path, bool render = false);
+    // Private copy of an already compiled model (no XML parsing)
+    CartPoleEnv(const mjModel* base_model, bool render = false);
     ~CartPoleEnv() override;
     
+    // Parse an MJCF file once, to share as base_model across many environments
+    // (see cartpole_model.h for generated N-link models)
+    static std::shared_ptr<const mjModel> loadModel(const std::string& model_path);
+    
     // Environment interface implementation
     State reset() override;
     StepResult step(Action action) override;
@@ -24,7 +34,7 @@ public:
     void close() override;
     
     // Environment metadata (implementing base class interface)
-    int getObservationSpaceSize() const override { return 4; }  // [x, x_dot, theta, theta_dot]
+    int getObservationSpaceSize() const override { return observation_->size(); }
     int getActionSpaceSize() const override { return 1; }  // [force]
     std::vector<double> getObservationSpaceLow() const override;
     std::vector<double> getObservationSpaceHigh() const override;
@@ -40,13 +50,50 @@ public:
     // Get current state
     State getCurrentState() const override;
     
+    // Poles on the cart (nq - 1); the default observation has 2 * (links + 1) entries
+    int getNumLinks() const { return model_->nq - 1; }
+    
+    // Observation layout; the default is [x, x_dot, theta, theta_dot] read from qpos/qvel
+    void setObservationSpec(const ObservationSpec& spec);
+    // Latest observation in place, valid until the next step/reset
+    const double* observation() const { return observation_buffer_.data(); }
+    
     // Set rendering mode
     void setRenderMode(bool render) override { render_enabled_ = render; }
     
+    // Seed initial-state and domain randomization sampling
+    void seed(unsigned int seed) override { rng_.seed(seed); }
+    
+    // States from reset/step/getCurrentState come from resource; with an arena
+    // the per-step path does not touch the heap (info strings fit in SSO)
+    void setMemoryResource(std::pmr::memory_resource* resource) override {
+        state_memory_ = resource ? resource : std::pmr::get_default_resource();
+    }
+    
+    // Start states: qpos0 plus uniform noise in [-half_width, half_width] on every
+    // qpos/qvel entry (default 0.05; 0 starts exactly in the XML pose)
+    void setInitialStateNoise(double half_width);
+    // Draw start states from a shared pool instead (nullptr restores the noise)
+    void setInitialStatePool(std::shared_ptr<const InitialStatePool> pool);
+    
+    void setMaxEpisodeSteps(int steps) { max_episode_steps_ = steps; }
+    
     // Check if window should close (for proper event handling)
     bool shouldClose() const;
     
+    // Domain randomization: PerEnvironment samples now, PerEpisode on every reset
+    void setRandomizer(std::shared_ptr<const DomainRandomizer> randomizer);
+    // Fix this environment to one variant (e.g. an entry of a variant table)
+    void setPhysicsVariant(const PhysicsVariant& variant);
+    const PhysicsVariant& getPhysicsVariant() const { return variant_; }
+    
+    // Record qpos/qvel/ctrl of every step for offline replay (nullptr disables)
+    void setRecorder(std::shared_ptr<TrajectoryRecorder> recorder) { recorder_ = std::move(recorder); }
+    
 private:
+    struct AdoptModel {};
+    CartPoleEnv(mjModel* model, bool render, AdoptModel);
+    
     // MuJoCo model and data
     mjModel* model_;
     mjData* data_;
@@ -72,11 +119,25 @@ private:
     // Rendering flag
     bool render_enabled_;
     
+    // Physical parameters currently patched into model_
+    std::shared_ptr<const DomainRandomizer> randomizer_;
+    PhysicsVariant variant_;
+    
+    std::shared_ptr<TrajectoryRecorder> recorder_;
+    std::shared_ptr<const InitialStatePool> initial_states_;
+    
+    // Compiled observation spec and the (history-stacked) observation it fills
+    std::unique_ptr<ObservationPipeline> observation_;
+    std::vector<double> observation_buffer_;
+    bool custom_observation_;
+    std::pmr::memory_resource* state_memory_;
+    
     // Helper functions
     void initializeRendering();
     void cleanupRendering();
     bool isDone() const;
-    double computeReward(const std::vector<double>& state, bool done) const;
+    double computeReward(bool done) const;
+    void advance();
 };
 
 #endif // CARTPOLE_ENV_H
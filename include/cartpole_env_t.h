@@ -0,0 +1,247 @@
+#ifndef CARTPOLE_ENV_T_H
+#define CARTPOLE_ENV_T_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "environment.h"
+#include "agent.h"
+#include "mujoco/mujoco.h"
+
+/**
+ * Compile-time specialized CartPole environment for tight inner loops.
+ *
+ * Reward and termination are policy types resolved at compile time, the
+ * observation is a fixed-size std::array, and nothing is virtual, so the
+ * compiler can inline the whole step around mj_step. Observations are laid
+ * out [q0, v0, q1, v1, ...], which for the single pole is the familiar
+ * [x, x_dot, theta, theta_dot] of CartPoleEnv.
+ */
+
+// Mean cosine of the accumulated link angles + 1, as in CartPoleEnv::computeReward
+// (hinges after the first are relative to their parent; cos(theta) + 1 for one pole)
+struct UprightReward {
+    template <typename Observation>
+    static double reward(const Observation& obs) {
+        const int links = static_cast<int>(obs.size()) / 2 - 1;
+        double theta = 0.0;
+        double upright = 0.0;
+        for (int j = 1; j <= links; ++j) {
+            theta += obs[2 * j];
+            upright += std::cos(theta);
+        }
+        return upright / links + 1.0;
+    }
+};
+
+// Cart leaves [-2.4, 2.4], as in CartPoleEnv::isDone
+struct CartBoundsTermination {
+    static constexpr double kXThreshold = 2.4;
+
+    template <typename Observation>
+    static bool done(const Observation& obs) {
+        return obs[0] < -kXThreshold || obs[0] > kXThreshold;
+    }
+};
+
+template <typename RewardPolicy, typename TerminationPolicy, int ObsDim = 4>
+class CartPoleEnvT {
+public:
+    static constexpr int kObsDim = ObsDim;
+    using Observation = std::array<double, ObsDim>;
+
+    struct Step {
+        Observation observation;
+        double reward;
+        bool done;
+        bool time_limit;
+    };
+
+    explicit CartPoleEnvT(const mjModel* base_model, int max_episode_steps = 500,
+                          double max_force = 10.0)
+        : model_(mj_copyModel(nullptr, base_model)), data_(nullptr),
+          max_force_(max_force), max_episode_steps_(max_episode_steps), current_step_(0),
+          rng_(std::random_device{}()), uniform_dist_(-0.05, 0.05) {
+        if (!model_) {
+            throw std::runtime_error("Failed to copy MuJoCo model");
+        }
+        if (model_->nq + model_->nv != ObsDim) {
+            mj_deleteModel(model_);
+            throw std::runtime_error("CartPoleEnvT: ObsDim must equal nq + nv of the model");
+        }
+        data_ = mj_makeData(model_);
+    }
+
+    ~CartPoleEnvT() {
+        mj_deleteData(data_);
+        mj_deleteModel(model_);
+    }
+
+    CartPoleEnvT(const CartPoleEnvT&) = delete;
+    CartPoleEnvT& operator=(const CartPoleEnvT&) = delete;
+
+    // Same start distribution as CartPoleEnv: qpos0 plus uniform noise in
+    // [-0.05, 0.05] on every qpos/qvel entry, written without mj_resetData
+    Observation reset() {
+        for (int i = 0; i < model_->nq; ++i) {
+            data_->qpos[i] = model_->qpos0[i] + uniform_dist_(rng_);
+        }
+        for (int i = 0; i < model_->nv; ++i) {
+            data_->qvel[i] = uniform_dist_(rng_);
+        }
+        mju_zero(data_->ctrl, model_->nu);
+        mju_zero(data_->act, model_->na);
+        mju_zero(data_->qacc_warmstart, model_->nv);
+        data_->time = 0.0;
+        // Observations read qpos/qvel only and mj_step runs its own forward pass
+        current_step_ = 0;
+        Observation obs;
+        observe(obs);
+        return obs;
+    }
+
+    Step step(double action) {
+        data_->ctrl[0] = std::max(-max_force_, std::min(max_force_, action));
+        mj_step(model_, data_);
+
+        Step result;
+        observe(result.observation);
+        result.time_limit = ++current_step_ >= max_episode_steps_;
+        result.done = TerminationPolicy::done(result.observation) || result.time_limit;
+        result.reward = RewardPolicy::reward(result.observation);
+        return result;
+    }
+
+    void observe(Observation& out) const {
+        for (int i = 0; i < ObsDim / 2; ++i) {
+            out[2 * i] = data_->qpos[i];
+            out[2 * i + 1] = data_->qvel[i];
+        }
+    }
+
+    void seed(unsigned int seed) { rng_.seed(seed); }
+
+    double maxForce() const { return max_force_; }
+    const mjModel* model() const { return model_; }
+    mjData* data() { return data_; }
+
+private:
+    mjModel* model_;
+    mjData* data_;
+    double max_force_;
+    int max_episode_steps_;
+    int current_step_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_dist_;
+};
+
+using FastCartPoleEnv = CartPoleEnvT<UprightReward, CartBoundsTermination, 4>;
+
+// Bang-bang controller of RuleBasedAgent, without virtual dispatch
+struct BangBangPolicy {
+    double max_force = 10.0;
+
+    template <typename Observation>
+    double act(const Observation& obs) const {
+        return obs[2] > 0.0 ? max_force : -max_force;
+    }
+};
+
+// Calls a dynamic Agent from the static loop (for comparison/reuse)
+class AgentPolicy {
+public:
+    explicit AgentPolicy(Agent& agent) : agent_(agent), state_(4) {}
+
+    template <typename Observation>
+    double act(const Observation& obs) {
+        state_.assign(obs.begin(), obs.end());
+        return agent_.act(state_);
+    }
+
+private:
+    Agent& agent_;
+    State state_;
+};
+
+struct EpisodeResultT {
+    int steps = 0;
+    double total_reward = 0.0;
+    bool terminated = false;
+};
+
+// Statically dispatched episode loop; Policy needs act(const Observation&)
+template <typename Env, typename Policy>
+EpisodeResultT runEpisodeT(Env& env, Policy& policy, int max_steps) {
+    EpisodeResultT result;
+    typename Env::Observation obs = env.reset();
+    for (int step = 0; step < max_steps; ++step) {
+        typename Env::Step next = env.step(policy.act(obs));
+        result.total_reward += next.reward;
+        result.steps = step + 1;
+        if (next.done) {
+            result.terminated = true;
+            break;
+        }
+        obs = next.observation;
+    }
+    return result;
+}
+
+/**
+ * Exposes a CartPoleEnvT through the virtual Environment interface.
+ */
+template <typename EnvT>
+class EnvironmentAdapter : public Environment {
+public:
+    explicit EnvironmentAdapter(const mjModel* base_model) : env_(base_model) {}
+
+    State reset() override {
+        auto obs = env_.reset();
+        return State(obs.begin(), obs.end());
+    }
+
+    StepResult step(Action action) override {
+        auto next = env_.step(action);
+        std::string info = next.done ? (next.time_limit ? "TimeLimit" : "Terminated") : "";
+        return std::make_tuple(State(next.observation.begin(), next.observation.end()),
+                               next.reward, next.done, info);
+    }
+
+    void render() override {}
+    void close() override {}
+
+    int getObservationSpaceSize() const override { return EnvT::kObsDim; }
+    int getActionSpaceSize() const override { return 1; }
+    std::vector<double> getObservationSpaceLow() const override {
+        return std::vector<double>(EnvT::kObsDim, -INFINITY);
+    }
+    std::vector<double> getObservationSpaceHigh() const override {
+        return std::vector<double>(EnvT::kObsDim, INFINITY);
+    }
+    double getActionSpaceLow() const override { return -env_.maxForce(); }
+    double getActionSpaceHigh() const override { return env_.maxForce(); }
+
+    std::string getName() const override { return "CartPoleT-v1"; }
+    std::string getDescription() const override {
+        return "Statically dispatched cart-pole exposed through Environment";
+    }
+
+    State getCurrentState() const override {
+        typename EnvT::Observation obs;
+        env_.observe(obs);
+        return State(obs.begin(), obs.end());
+    }
+
+    void seed(unsigned int seed) override { env_.seed(seed); }
+
+    EnvT& inner() { return env_; }
+
+private:
+    EnvT env_;
+};
+
+#endif // CARTPOLE_ENV_T_H
@@ -0,0 +1,34 @@
+#ifndef CARTPOLE_MODEL_H
+#define CARTPOLE_MODEL_H
+
+#include <memory>
+#include <string>
+#include "mujoco/mujoco.h"
+
+/**
+ * Procedural N-link cart-pole (single, double, triple, ... pendulum on a cart).
+ *
+ * With num_links = 1 and the default dimensions the generated MJCF matches
+ * mujoco/cartpole.xml, including object and sensor names. Link 1 keeps the
+ * names "pole"/"hinge" (so DomainRandomizer and the sensor spec still apply);
+ * link k > 1 is "pole<k>"/"hinge<k>" with a hinge relative to its parent.
+ * State size is nq + nv = 2 * (num_links + 1).
+ */
+struct CartPoleModelSpec {
+    int num_links = 1;
+    double link_length = 0.5;
+    double link_radius = 0.02;
+    double link_mass = 0.1;
+    double tip_mass = 0.05;        // Sphere at the end of the last link
+    double cart_mass = 1.0;
+    double max_force = 10.0;
+    double timestep = 0.01;
+};
+
+// MJCF text for the spec
+std::string generateCartPoleXML(const CartPoleModelSpec& spec);
+
+// Compile the generated MJCF from memory (no file on disk)
+std::shared_ptr<const mjModel> buildCartPoleModel(const CartPoleModelSpec& spec);
+
+#endif // CARTPOLE_MODEL_H
@@ -0,0 +1,176 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Binary checkpoint format for agent parameters, optimizer and RNG state.
+ *
+ * Layout: CheckpointHeader | BlobEntry[num_blobs] | blobs
+ * Every blob starts on a kCheckpointAlignment boundary, so a memory-mapped
+ * file can be used directly as parameter storage without deserialization.
+ */
+constexpr uint32_t kCheckpointMagic = 0x4B435043;  // "CPCK"
+constexpr uint32_t kCheckpointVersion = 1;
+constexpr size_t kCheckpointAlignment = 64;
+
+enum class BlobType : uint32_t {
+    Bytes = 0,
+    Float32 = 1,
+    Float64 = 2,
+    Int32 = 3,
+    Int64 = 4
+};
+
+struct CheckpointHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_blobs;
+    uint32_t reserved;
+    uint64_t file_size;
+    uint64_t step;
+    char agent_name[32];
+};
+
+struct BlobEntry {
+    char name[48];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;  // From start of file, kCheckpointAlignment aligned
+    uint64_t size;    // In bytes
+};
+
+template <typename T> struct BlobTypeOf;
+template <> struct BlobTypeOf<char> { static constexpr BlobType value = BlobType::Bytes; };
+template <> struct BlobTypeOf<float> { static constexpr BlobType value = BlobType::Float32; };
+template <> struct BlobTypeOf<double> { static constexpr BlobType value = BlobType::Float64; };
+template <> struct BlobTypeOf<int32_t> { static constexpr BlobType value = BlobType::Int32; };
+template <> struct BlobTypeOf<int64_t> { static constexpr BlobType value = BlobType::Int64; };
+
+/**
+ * Collects named blobs and publishes them as one checkpoint file.
+ * Blob data is referenced, not copied, so it must stay alive until commit().
+ */
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(const std::string& agent_name);
+
+    void setStep(uint64_t step) { step_ = step; }
+
+    void addBlob(const std::string& name, BlobType type, const void* data, size_t bytes);
+
+    template <typename T>
+    void add(const std::string& name, const T* data, size_t count) {
+        addBlob(name, BlobTypeOf<T>::value, data, count * sizeof(T));
+    }
+
+    // Stores a copy, for small values that do not outlive the caller
+    template <typename T>
+    void addCopy(const std::string& name, const T* data, size_t count) {
+        const char* bytes = reinterpret_cast<const char*>(data);
+        owned_.push_back(std::make_unique<std::string>(bytes, count * sizeof(T)));
+        addBlob(name, BlobTypeOf<T>::value, owned_.back()->data(), owned_.back()->size());
+    }
+
+    // Stores a copy of the string (e.g. serialized RNG state)
+    void addString(const std::string& name, const std::string& value) {
+        addCopy(name, value.data(), value.size());
+    }
+
+    // Write to a unique temporary file, fsync, rename over filepath, then
+    // fsync the directory so the rename survives a crash
+    void commit(const std::string& filepath) const;
+
+private:
+    struct PendingBlob {
+        std::string name;
+        BlobType type;
+        const void* data;
+        size_t bytes;
+    };
+
+    std::string agent_name_;
+    uint64_t step_;
+    std::vector<PendingBlob> blobs_;
+    std::vector<std::unique_ptr<std::string>> owned_;
+};
+
+/**
+ * Read-only, zero-copy view of a blob inside a mapped checkpoint.
+ */
+template <typename T>
+struct BlobView {
+    const T* data = nullptr;
+    size_t size = 0;
+
+    bool empty() const { return size == 0; }
+    const T& operator[](size_t i) const { return data[i]; }
+    const T* begin() const { return data; }
+    const T* end() const { return data + size; }
+};
+
+/**
+ * Checkpoint file mapped read-only into memory.
+ * Views stay valid for as long as the MappedCheckpoint is alive.
+ */
+class MappedCheckpoint {
+public:
+    static std::shared_ptr<const MappedCheckpoint> open(const std::string& filepath);
+    ~MappedCheckpoint();
+
+    MappedCheckpoint(const MappedCheckpoint&) = delete;
+    MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+    bool has(const std::string& name) const;
+    uint64_t step() const { return header_->step; }
+    std::string agentName() const;
+
+    template <typename T>
+    BlobView<T> view(const std::string& name) const {
+        const BlobEntry& entry = find(name, BlobTypeOf<T>::value);
+        if (entry.size % sizeof(T) != 0) {
+            throw std::runtime_error("Checkpoint blob size is not a whole number of elements: " + name);
+        }
+        // The mapping is page aligned, so the offset decides the element alignment
+        if (entry.offset % alignof(T) != 0) {
+            throw std::runtime_error("Checkpoint blob is misaligned: " + name);
+        }
+        return {reinterpret_cast<const T*>(base_ + entry.offset), entry.size / sizeof(T)};
+    }
+
+    std::string string(const std::string& name) const;
+
+private:
+    MappedCheckpoint(const char* base, size_t size);
+
+    const BlobEntry& find(const std::string& name, BlobType type) const;
+
+    const char* base_;
+    size_t size_;
+    const CheckpointHeader* header_;
+    const BlobEntry* entries_;
+};
+
+/**
+ * Polls a checkpoint path and maps the file again whenever a new version has
+ * been published (atomic rename gives every version a fresh inode).
+ */
+class CheckpointWatcher {
+public:
+    explicit CheckpointWatcher(const std::string& filepath);
+
+    // Returns the newly published checkpoint, or nullptr if nothing changed
+    std::shared_ptr<const MappedCheckpoint> poll();
+
+private:
+    std::string filepath_;
+    uint64_t last_inode_;
+    int64_t last_mtime_ns_;
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,96 @@
+#ifndef DOMAIN_RANDOMIZER_H
+#define DOMAIN_RANDOMIZER_H
+
+#include <random>
+#include <vector>
+#include "mujoco/mujoco.h"
+
+/**
+ * One physical variant of the CartPole model, expressed relative to the
+ * nominal values compiled from mujoco/cartpole.xml (or a generated N-link
+ * model, where the pole scales apply to every link). A variant is a few
+ * doubles, so tables of thousands of them cost next to nothing.
+ */
+struct PhysicsVariant {
+    double cart_mass_scale = 1.0;
+    double pole_mass_scale = 1.0;
+    double pole_length_scale = 1.0;
+    double joint_damping_scale = 1.0;  // Of every hinge's nominal damping
+    double actuator_gear_scale = 1.0;
+    double timestep_scale = 1.0;
+};
+
+/**
+ * Samples PhysicsVariants and patches them into an mjModel in place.
+ *
+ * Nominal values are captured once from a compiled base model. apply()
+ * always writes absolute values derived from those nominals, so an
+ * environment can keep a single private model copy and re-patch it every
+ * episode without drift and without re-parsing the XML.
+ */
+class DomainRandomizer {
+public:
+    enum class Mode {
+        PerEnvironment,  // Sample once when attached to an environment
+        PerEpisode       // Sample again on every reset
+    };
+
+    struct Range {
+        double low;
+        double high;
+    };
+
+    struct Config {
+        Mode mode = Mode::PerEpisode;
+        Range cart_mass_scale = {1.0, 1.0};
+        Range pole_mass_scale = {1.0, 1.0};
+        Range pole_length_scale = {1.0, 1.0};
+        Range joint_damping_scale = {1.0, 1.0};
+        Range actuator_gear_scale = {1.0, 1.0};
+        Range timestep_scale = {1.0, 1.0};
+    };
+
+    DomainRandomizer(const mjModel* base_model, const Config& config);
+
+    Mode getMode() const { return config_.mode; }
+
+    PhysicsVariant sample(std::mt19937& rng) const;
+
+    // Reproducible table of variants, e.g. one per environment
+    std::vector<PhysicsVariant> makeVariantTable(int count, unsigned int seed) const;
+
+    // Overwrite the randomized fields of model (which must share the base
+    // model's structure). Derived constants are recomputed using data only
+    // when masses or lengths changed; gear, damping and timestep need none.
+    void apply(const PhysicsVariant& variant, mjModel* model, mjData* data) const;
+
+private:
+    Config config_;
+
+    // Nominal values of one pole link (the body of a hinge joint)
+    struct Link {
+        int body;
+        int dof;
+        bool scale_pos;                   // Attached to the end of the previous link
+        double mass;
+        double pos[3];
+        double ipos[3];
+        double inertia[3];
+        double damping;
+    };
+
+    // Indices into the compiled model
+    int cart_body_;
+    int actuator_;
+    std::vector<Link> links_;
+    std::vector<int> pole_geoms_;
+
+    // Nominal values captured from the base model
+    double cart_mass_;
+    std::vector<double> pole_geom_pos_;   // 3 per pole geom
+    std::vector<double> pole_geom_size_;  // 3 per pole geom
+    double gear_;
+    double timestep_;
+};
+
+#endif // DOMAIN_RANDOMIZER_H
@@ -0,0 +1,118 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <array>
+#include <cmath>
+
+/**
+ * Forward-mode dual number with N tangent directions.
+ *
+ * A Dual carries a value and its derivative with respect to N seeded
+ * inputs, so one evaluation of templated code yields the value and N
+ * partial derivatives. Storage is inline (no allocation) and N is a
+ * compile-time constant, so the tangent loops unroll.
+ */
+template <int N>
+struct Dual {
+    double value = 0.0;
+    std::array<double, N> grad{};
+
+    Dual() = default;
+    Dual(double v) : value(v) {}
+
+    // Independent variable: derivative 1 in direction `index`
+    static Dual variable(double v, int index) {
+        Dual d(v);
+        d.grad[index] = 1.0;
+        return d;
+    }
+
+    Dual& operator+=(const Dual& o) {
+        value += o.value;
+        for (int i = 0; i < N; ++i) {
+            grad[i] += o.grad[i];
+        }
+        return *this;
+    }
+    Dual& operator-=(const Dual& o) {
+        value -= o.value;
+        for (int i = 0; i < N; ++i) {
+            grad[i] -= o.grad[i];
+        }
+        return *this;
+    }
+    Dual& operator*=(const Dual& o) {
+        for (int i = 0; i < N; ++i) {
+            grad[i] = grad[i] * o.value + value * o.grad[i];
+        }
+        value *= o.value;
+        return *this;
+    }
+    Dual& operator/=(const Dual& o) {
+        const double inv = 1.0 / o.value;
+        for (int i = 0; i < N; ++i) {
+            grad[i] = (grad[i] - value * inv * o.grad[i]) * inv;
+        }
+        value *= inv;
+        return *this;
+    }
+};
+
+template <int N> Dual<N> operator-(Dual<N> a) {
+    a.value = -a.value;
+    for (int i = 0; i < N; ++i) {
+        a.grad[i] = -a.grad[i];
+    }
+    return a;
+}
+template <int N> Dual<N> operator+(Dual<N> a, const Dual<N>& b) { return a += b; }
+template <int N> Dual<N> operator-(Dual<N> a, const Dual<N>& b) { return a -= b; }
+template <int N> Dual<N> operator*(Dual<N> a, const Dual<N>& b) { return a *= b; }
+template <int N> Dual<N> operator/(Dual<N> a, const Dual<N>& b) { return a /= b; }
+
+// Mixed with plain doubles (constants have zero tangent)
+template <int N> Dual<N> operator+(Dual<N> a, double b) { a.value += b; return a; }
+template <int N> Dual<N> operator+(double a, Dual<N> b) { b.value += a; return b; }
+template <int N> Dual<N> operator-(Dual<N> a, double b) { a.value -= b; return a; }
+template <int N> Dual<N> operator-(double a, const Dual<N>& b) { return -b + a; }
+template <int N> Dual<N> operator*(Dual<N> a, double b) {
+    a.value *= b;
+    for (int i = 0; i < N; ++i) {
+        a.grad[i] *= b;
+    }
+    return a;
+}
+template <int N> Dual<N> operator*(double a, const Dual<N>& b) { return b * a; }
+template <int N> Dual<N> operator/(const Dual<N>& a, double b) { return a * (1.0 / b); }
+template <int N> Dual<N> operator/(double a, const Dual<N>& b) { return Dual<N>(a) / b; }
+
+template <int N> Dual<N> sin(const Dual<N>& a) {
+    Dual<N> r(std::sin(a.value));
+    const double d = std::cos(a.value);
+    for (int i = 0; i < N; ++i) {
+        r.grad[i] = d * a.grad[i];
+    }
+    return r;
+}
+template <int N> Dual<N> cos(const Dual<N>& a) {
+    Dual<N> r(std::cos(a.value));
+    const double d = -std::sin(a.value);
+    for (int i = 0; i < N; ++i) {
+        r.grad[i] = d * a.grad[i];
+    }
+    return r;
+}
+template <int N> Dual<N> tanh(const Dual<N>& a) {
+    Dual<N> r(std::tanh(a.value));
+    const double d = 1.0 - r.value * r.value;
+    for (int i = 0; i < N; ++i) {
+        r.grad[i] = d * a.grad[i];
+    }
+    return r;
+}
+
+// Primal value of a double or a Dual, for branches such as clamping
+inline double primal(double x) { return x; }
+template <int N> double primal(const Dual<N>& x) { return x.value; }
+
+#endif // DUAL_H
@@ -5,9 +5,11 @@
 #include <tuple>
 #include <string>
 #include <memory>
+#include <memory_resource>
 
 // Type aliases for clarity
-using State = std::vector<double>;
+// State is allocator-aware so episode-scoped data can live in an EpisodeArena
+using State = std::pmr::vector<double>;
 using Action = double;  // For continuous control (can be extended to vector later)
 using Reward = double;
 using Done = bool;
@@ -18,16 +20,34 @@ using StepResult = std::tuple<State, Reward, Done, Info>;
 
 // Experience tuple for learning: (state, action, reward, next_state, done)
 struct Experience {
+    using allocator_type = std::pmr::polymorphic_allocator<double>;
+    
     State state;
     Action action;
     Reward reward;
     State next_state;
     Done done;
     
-    Experience(const State& s, Action a, Reward r, const State& ns, Done d)
-        : state(s), action(a), reward(r), next_state(ns), done(d) {}
+    Experience(const State& s, Action a, Reward r, const State& ns, Done d,
+               const allocator_type& alloc = {})
+        : state(s, alloc), action(a), reward(r), next_state(ns, alloc), done(d) {}
+    
+    // Allocator-extended copy/move, used when stored in a Trajectory
+    Experience(const Experience& other) = default;
+    Experience(Experience&& other) = default;
+    Experience(const Experience& other, const allocator_type& alloc)
+        : state(other.state, alloc), action(other.action), reward(other.reward),
+          next_state(other.next_state, alloc), done(other.done) {}
+    Experience(Experience&& other, const allocator_type& alloc)
+        : state(std::move(other.state), alloc), action(other.action), reward(other.reward),
+          next_state(std::move(other.next_state), alloc), done(other.done) {}
+    Experience& operator=(const Experience& other) = default;
+    Experience& operator=(Experience&& other) = default;
 };
 
+// Sequence of experiences; elements share the trajectory's memory resource
+using Trajectory = std::pmr::vector<Experience>;
+
 /**
  * Abstract base class for all RL environments.
  * Provides the standard interface that all environments must implement.
@@ -59,6 +79,13 @@ public:
     
     // Optional: Set rendering mode
     virtual void setRenderMode(bool render) {}
+    
+    // Optional: Seed the environment's random number generator
+    virtual void seed(unsigned int seed) {}
+    
+    // Optional: Allocate returned States from resource (nullptr = default heap).
+    // The resource must outlive every State returned while it is set.
+    virtual void setMemoryResource(std::pmr::memory_resource* resource) {}
 };
 
 #endif // ENVIRONMENT_H
@@ -0,0 +1,50 @@
+#ifndef EPISODE_ARENA_H
+#define EPISODE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+/**
+ * Monotonic memory resource for data that lives exactly one episode
+ * (experiences, trajectories, scratch states).
+ *
+ * Allocation is a pointer bump and reset() discards everything at once.
+ * If an episode overflows the owned buffer, the buffer is enlarged at the
+ * next reset, so in steady state no memory goes back to the global heap and
+ * concurrent runners do not contend on the allocator.
+ */
+class EpisodeArena {
+public:
+    explicit EpisodeArena(size_t initial_bytes = 256 * 1024);
+
+    EpisodeArena(const EpisodeArena&) = delete;
+    EpisodeArena& operator=(const EpisodeArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*resource_; }
+
+    // Invalidate all allocations made since the previous reset
+    void reset();
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    // Forwards to the heap and records how far an episode overflowed
+    class OverflowTracker : public std::pmr::memory_resource {
+    public:
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t size, size_t alignment) override;
+        void do_deallocate(void* p, size_t size, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    size_t capacity_;
+    std::unique_ptr<std::byte[]> buffer_;
+    OverflowTracker overflow_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+#endif // EPISODE_ARENA_H
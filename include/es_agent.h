@@ -0,0 +1,89 @@
+#ifndef ES_AGENT_H
+#define ES_AGENT_H
+
+#include "agent.h"
+#include "aligned_buffer.h"
+#include <cstdint>
+#include <random>
+
+/**
+ * Deterministic MLP policy trained by evolution strategies (see ESTrainer).
+ *
+ * Input is the observation with the pole angle replaced by (sin, cos), one
+ * tanh hidden layer (or none for a linear policy), and a tanh output scaled
+ * to [-max_force, max_force]. All parameters live in one flat vector so a
+ * perturbation is a single slice of the noise table. learn() is a no-op;
+ * parameters change only through applyGradient().
+ */
+class ESAgent : public Agent {
+public:
+    struct Config {
+        int observation_size = 4;
+        int hidden_size = 16;         // 0 = linear policy
+        int angle_index = 2;          // Fed as (sin, cos); -1 passes all inputs raw
+        double max_force = 10.0;
+        // Adam on the ES gradient estimate (ascent)
+        double learning_rate = 0.02;
+        double beta1 = 0.9;
+        double beta2 = 0.999;
+        double adam_epsilon = 1e-8;
+        double weight_decay = 0.005;
+        unsigned int seed = 0;        // Initial weights
+    };
+
+    ESAgent();
+    explicit ESAgent(const Config& config);
+    ~ESAgent() override = default;
+
+    // Agent interface implementation
+    Action act(const State& state) override;
+    void actBatch(const State* states, size_t count, Action* actions) override;
+    void learn(const Experience& experience) override {}
+    std::unique_ptr<Agent> clone() const override;
+
+    // Agent metadata
+    std::string getName() const override { return "ESAgent"; }
+    std::string getDescription() const override {
+        return "Tanh MLP policy optimized by antithetic evolution strategies";
+    }
+
+    std::vector<std::pair<std::string, double>> getStats() const override;
+
+    // Flat parameter vector
+    int numParameters() const { return static_cast<int>(params_.size()); }
+    const float* parameters() const { return params_.data(); }
+    void setParameters(const float* params);
+
+    // Policy output for an arbitrary parameter vector; scratch needs scratchSize() floats.
+    // Thread-safe, used by ES workers for perturbed rollouts.
+    Action policy(const float* params, const State& state, float* scratch) const;
+    int scratchSize() const { return input_size_ + config_.hidden_size; }
+
+    // One Adam ascent step along the gradient estimate (with weight decay)
+    void applyGradient(const float* gradient);
+    int64_t generation() const { return adam_steps_; }
+
+protected:
+    // Checkpoint hooks (parameters, Adam moments)
+    void saveState(CheckpointWriter& writer) const override;
+    void loadState(const std::shared_ptr<const MappedCheckpoint>& checkpoint) override;
+
+private:
+    Config config_;
+    int input_size_;
+
+    // Layout: W1 [hidden][input], b1 [hidden], w2 [hidden], b2; or w [input], b when linear
+    AlignedVector<float> params_;
+    AlignedVector<float> adam_m_;
+    AlignedVector<float> adam_v_;
+    int64_t adam_steps_;
+    double last_update_norm_;
+
+    std::vector<float> scratch_;
+    std::vector<float> batch_input_;    // [batch][input]
+    std::vector<float> batch_output_;
+
+    void encodeInput(const State& state, float* input) const;
+};
+
+#endif // ES_AGENT_H
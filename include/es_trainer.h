@@ -0,0 +1,88 @@
+#ifndef ES_TRAINER_H
+#define ES_TRAINER_H
+
+#include "environment.h"
+#include "episode_arena.h"
+#include "es_agent.h"
+#include "noise_table.h"
+#include "telemetry.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * OpenAI-style evolution strategies for ESAgent.
+ *
+ * Each generation evaluates antithetic pairs theta +/- sigma * eps on
+ * per-thread environments, where eps is a slice of the shared NoiseTable.
+ * Workers only report (noise index, return+, return-); the gradient is
+ * reconstructed from the table with centered-rank fitness shaping and
+ * handed to the agent's Adam step. Each worker's environment allocates the
+ * States of an episode from that worker's EpisodeArena.
+ */
+class ESTrainer {
+public:
+    using EnvironmentFactory = std::function<std::unique_ptr<Environment>()>;
+
+    struct Config {
+        int population_pairs = 32;        // Antithetic pairs per generation (2x episodes)
+        double sigma = 0.05;              // Perturbation scale
+        int num_threads = 0;              // 0 = hardware concurrency
+        int max_steps = 500;              // Per episode
+        unsigned int seed = 1;            // Noise indices and episode seeds
+        bool telemetry = true;            // Publish metrics in Telemetry::global()
+    };
+
+    struct PairResult {
+        size_t noise_index;
+        double positive_return;
+        double negative_return;
+        int steps;
+    };
+
+    struct Generation {
+        int64_t generation = 0;
+        double mean_return = 0.0;
+        double max_return = 0.0;
+        double min_return = 0.0;
+        long long steps = 0;
+    };
+
+    ESTrainer(EnvironmentFactory factory, std::shared_ptr<const NoiseTable> noise,
+              const Config& config);
+
+    // Evaluate one population around the agent's parameters and update them
+    Generation step(ESAgent& agent);
+
+    // Ranks mapped to [-0.5, 0.5]; tied values get their average rank
+    static void centeredRanks(const std::vector<double>& values, std::vector<double>& out);
+
+    static void printGeneration(const Generation& generation);
+
+private:
+    struct Worker {
+        std::unique_ptr<Environment> env;
+        std::unique_ptr<EpisodeArena> arena;   // Rewound at the start of every rollout
+        std::vector<float> params;
+        std::vector<float> scratch;
+    };
+
+    EnvironmentFactory factory_;
+    std::shared_ptr<const NoiseTable> noise_;
+    Config config_;
+    std::vector<Worker> workers_;
+
+    std::vector<PairResult> results_;
+    std::vector<double> returns_;
+    std::vector<double> ranks_;
+    std::vector<float> gradient_;
+
+    Telemetry::Counter* steps_total_;
+    Telemetry::Counter* episodes_total_;
+    Telemetry::Counter* updates_total_;
+    Telemetry::Gauge* mean_return_;
+
+    double rollout(Worker& worker, const ESAgent& agent, unsigned int seed, int& steps);
+};
+
+#endif // ES_TRAINER_H
@@ -4,6 +4,9 @@
 #include "environment.h"
 #include "agent.h"
 #include "config.h"
+#include "normalizer.h"
+#include "episode_arena.h"
+#include "telemetry.h"
 #include <memory>
 #include <vector>
 #include <string>
@@ -23,8 +26,14 @@ public:
         std::string log_file = "experiment.log";
         bool save_model = false;
         std::string model_save_path = "model.bin";
+        int checkpoint_frequency = 0;  // Publish a checkpoint every N episodes (0 = only at end)
+        bool resume = false;           // Load model_save_path before training if it exists
+        int telemetry_port = 0;        // Serve Prometheus metrics on this port (0 = off)
+        std::string telemetry_file;    // Also/instead publish them to this file
     };
     
+    // Outlives its episode, so it is kept on the regular heap (the reason
+    // strings fit the small-string buffer; agent_stats is one allocation)
     struct EpisodeStats {
         int episode;
         int steps;
@@ -45,6 +54,9 @@ public:
     // Run single episode (useful for evaluation)
     EpisodeStats runEpisode(int max_steps = 1000, bool render = false);
     
+    // Normalize observations/rewards between env and agent (also saved with the agent)
+    void setNormalizer(std::shared_ptr<Normalizer> normalizer);
+    
     // Getters
     Environment* getEnvironment() const { return env_.get(); }
     Agent* getAgent() const { return agent_.get(); }
@@ -57,6 +69,18 @@ public:
 private:
     std::unique_ptr<Environment> env_;
     std::unique_ptr<Agent> agent_;
+    std::shared_ptr<Normalizer> normalizer_;
+    std::unique_ptr<NormalizerWorker> normalizer_worker_;
+    
+    // Per-step states and experiences; rewound at the start of every episode
+    EpisodeArena arena_;
+    
+    // Live metrics in Telemetry::global(), exported while runExperiment runs
+    Telemetry::Counter& steps_total_;
+    Telemetry::Counter& episodes_total_;
+    Telemetry::Gauge& episode_reward_;
+    Telemetry::Gauge& episode_steps_;
+    Telemetry::Gauge& reward_moving_average_;
     
     void logToFile(const std::string& message, const std::string& filename);
     double calculateMovingAverage(const std::vector<EpisodeStats>& stats, int window_size = 100);
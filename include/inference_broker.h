@@ -0,0 +1,138 @@
+#ifndef INFERENCE_BROKER_H
+#define INFERENCE_BROKER_H
+
+#include "agent.h"
+#include "telemetry.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+
+/**
+ * Log-linear latency histogram: every power of two is split into four
+ * buckets, so quantiles are within ~19% of the true value. Recording is a
+ * single relaxed increment and safe from any thread.
+ */
+class LatencyHistogram {
+public:
+    void record(std::chrono::nanoseconds latency);
+
+    uint64_t count() const;
+    // Upper edge of the bucket holding quantile q in [0, 1], in microseconds
+    double quantileMicros(double q) const;
+    double meanMicros() const;
+    void reset();
+
+private:
+    static constexpr int kSubBuckets = 4;
+    static constexpr int kBuckets = 64 * kSubBuckets;
+
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> total_ns_{0};
+
+    static int bucketIndex(uint64_t ns);
+    static double bucketUpperNanos(int index);
+};
+
+/**
+ * Coalesces act() requests from many environment threads into batched
+ * forward passes of one agent.
+ *
+ * submit() enqueues an observation and returns a future. A single broker
+ * thread waits until max_batch requests are queued or the oldest one has
+ * waited max_delay_us, calls Agent::actBatch() once and fulfils the
+ * futures. A larger batch or deadline raises throughput at the cost of
+ * latency; latency() reports the submit-to-result distribution. The agent
+ * is only ever used from the broker thread.
+ */
+class InferenceBroker {
+public:
+    struct Config {
+        int max_batch = 64;
+        int max_delay_us = 200;        // Deadline measured from the oldest queued request
+        bool telemetry = true;         // Publish metrics in Telemetry::global()
+    };
+
+    explicit InferenceBroker(std::shared_ptr<Agent> agent);
+    InferenceBroker(std::shared_ptr<Agent> agent, const Config& config);
+    // Answers every queued request before returning
+    ~InferenceBroker();
+
+    InferenceBroker(const InferenceBroker&) = delete;
+    InferenceBroker& operator=(const InferenceBroker&) = delete;
+
+    std::future<Action> submit(State state);
+    // Blocking convenience wrapper
+    Action act(const State& state) { return submit(state).get(); }
+
+    const LatencyHistogram& latency() const { return latency_; }
+    uint64_t requests() const { return requests_.load(std::memory_order_relaxed); }
+    uint64_t batches() const { return batches_.load(std::memory_order_relaxed); }
+    double meanBatchSize() const;
+
+    std::vector<std::pair<std::string, double>> getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        State state;
+        std::promise<Action> result;
+        Clock::time_point submitted;
+    };
+
+    std::shared_ptr<Agent> agent_;
+    Config config_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::vector<Request> queue_;
+    bool stopping_;
+
+    LatencyHistogram latency_;
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> batches_;
+
+    Telemetry::Counter* requests_total_;
+    Telemetry::Counter* batches_total_;
+    Telemetry::Gauge* queue_depth_;
+    Telemetry::Gauge* batch_size_;
+    Telemetry::Gauge* latency_p99_;
+
+    std::thread thread_;
+
+    void run();
+    void process(std::vector<Request>& batch, std::vector<State>& states, std::vector<Action>& actions);
+};
+
+/**
+ * Agent front end of a shared broker, so code written against Agent (the
+ * evaluator, the rollout loops) runs unchanged. clone() returns another
+ * front end of the same broker: each worker thread gets its own clone and
+ * all of them feed one batched model. learn() is a no-op.
+ */
+class BrokeredAgent : public Agent {
+public:
+    explicit BrokeredAgent(std::shared_ptr<InferenceBroker> broker);
+
+    Action act(const State& state) override { return broker_->act(state); }
+    void learn(const Experience& experience) override {}
+    std::unique_ptr<Agent> clone() const override;
+
+    std::string getName() const override { return "BrokeredAgent"; }
+    std::string getDescription() const override {
+        return "Forwards act() to a dynamic-batching inference broker";
+    }
+
+    std::vector<std::pair<std::string, double>> getStats() const override {
+        return broker_->getStats();
+    }
+
+private:
+    std::shared_ptr<InferenceBroker> broker_;
+};
+
+#endif // INFERENCE_BROKER_H
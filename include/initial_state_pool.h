@@ -0,0 +1,44 @@
+#ifndef INITIAL_STATE_POOL_H
+#define INITIAL_STATE_POOL_H
+
+#include <random>
+#include <vector>
+#include "trajectory_recorder.h"
+#include "mujoco/mujoco.h"
+
+/**
+ * Start states for CartPoleEnv::reset, stored contiguously as [qpos | qvel].
+ *
+ * A pool can be filled from a distribution up front, or from recorded
+ * trajectories: taking only the last frames of each episode and widening
+ * that window over training gives a reverse curriculum. Read-only once
+ * built, so many environments can share one pool.
+ */
+class InitialStatePool {
+public:
+    InitialStatePool(int nq, int nv);
+
+    // count states of qpos0 plus uniform noise in [-half_width, half_width] on every entry
+    static InitialStatePool uniform(const mjModel* model, int count, double half_width, unsigned int seed);
+
+    void add(const double* qpos, const double* qvel);
+    // Every stride-th frame of each episode, limited to the last max_frames_from_end
+    // frames when that is >= 0. Returns the number of states added.
+    int addTrajectories(const TrajectoryFile& file, int stride = 1, int max_frames_from_end = -1);
+
+    int nq() const { return nq_; }
+    int nv() const { return nv_; }
+    int size() const { return static_cast<int>(states_.size() / (nq_ + nv_)); }
+    bool empty() const { return states_.empty(); }
+
+    // [qpos | qvel] of state i
+    const double* state(int i) const { return states_.data() + static_cast<size_t>(i) * (nq_ + nv_); }
+    const double* sample(std::mt19937& rng) const;
+
+private:
+    int nq_;
+    int nv_;
+    std::vector<double> states_;
+};
+
+#endif // INITIAL_STATE_POOL_H
@@ -0,0 +1,136 @@
+#ifndef MCTS_AGENT_H
+#define MCTS_AGENT_H
+
+#include "agent.h"
+#include "aligned_buffer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "mujoco/mujoco.h"
+
+/**
+ * Parallel Monte Carlo tree search over evenly spaced forces.
+ *
+ * Every act() plans from the observed state by restoring it into per-thread
+ * mjData copies of the agent's model. The observation must use the default
+ * joint-state layout [q0, v0, q1, v1, ...] so qpos/qvel can be rebuilt.
+ *
+ * Tree nodes live in one preallocated arena; a node's children are a
+ * contiguous block referenced by the index of the first one. Value
+ * statistics are shared between nodes whose quantized states match,
+ * through a transposition table that is invalidated in O(1) by bumping a
+ * generation tag on every search. All threads search the same tree:
+ * visits are atomic, values are accumulated with CAS, and a virtual loss
+ * pushes concurrent threads onto different branches. The helper threads
+ * are started once and park on a condition variable between searches.
+ */
+class MCTSAgent : public Agent {
+public:
+    struct Config {
+        int num_actions = 5;
+        double max_force = 10.0;
+        int num_simulations = 2000;    // Per act()
+        int num_threads = 0;           // 0 = hardware concurrency
+        int max_depth = 50;            // Tree depth; deeper leaves are evaluated by rollout
+        int rollout_depth = 50;        // Random-action rollout from a new leaf
+        double gamma = 0.99;
+        double exploration = 1.0;      // UCT constant on values normalized to [0, 1]
+        int virtual_loss = 1;          // Visits pre-counted per in-flight simulation
+        int max_nodes = 1 << 18;
+        int table_size = 1 << 18;      // Transposition entries, power of two
+        double position_quantum = 1e-3;
+        double velocity_quantum = 1e-2;
+        double x_threshold = 2.4;      // Termination as in CartPoleEnv
+        unsigned int seed = 0;
+    };
+
+    explicit MCTSAgent(std::shared_ptr<const mjModel> model);
+    MCTSAgent(std::shared_ptr<const mjModel> model, const Config& config);
+    ~MCTSAgent() override;
+
+    MCTSAgent(const MCTSAgent&) = delete;
+    MCTSAgent& operator=(const MCTSAgent&) = delete;
+
+    // Agent interface implementation
+    Action act(const State& state) override;
+    void learn(const Experience& experience) override {}
+    std::unique_ptr<Agent> clone() const override;
+
+    // Agent metadata
+    std::string getName() const override { return "MCTSAgent"; }
+    std::string getDescription() const override {
+        return "Parallel UCT search with transpositions and virtual loss";
+    }
+
+    std::vector<std::pair<std::string, double>> getStats() const override;
+
+private:
+    struct Stats {
+        std::atomic<int32_t> visits{0};
+        std::atomic<double> value_sum{0.0};
+    };
+
+    struct Node {
+        std::atomic<uint32_t> children{0};   // kUnexpanded, kExpanding or first child index
+        Stats* stats = nullptr;              // Shared via the table, or own_stats
+        Stats own_stats;
+        float reward = 0.0f;                 // Reward of the transition into this node
+        bool terminal = false;
+    };
+
+    struct TableEntry {
+        std::atomic<uint64_t> tag{0};        // Hash bits | generation, 0 = never used
+        Stats stats;
+    };
+
+    std::shared_ptr<const mjModel> model_;
+    Config config_;
+    int num_threads_;
+    int state_size_;
+    std::vector<double> actions_;
+    std::vector<double> quantum_;            // Per state entry
+    std::vector<mjData*> thread_data_;
+
+    std::unique_ptr<Node[]> nodes_;
+    AlignedVector<double> node_states_;      // [node][qpos | qvel]
+    std::atomic<uint32_t> next_node_;
+
+    std::unique_ptr<TableEntry[]> table_;
+    uint64_t generation_;
+
+    // Helper threads 1..num_threads_-1; act() searches on the calling thread
+    std::vector<std::thread> pool_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_wake_;
+    std::condition_variable pool_done_;
+    uint64_t search_epoch_;
+    int pool_busy_;
+    bool pool_stopping_;
+
+    std::atomic<int> simulations_started_;
+    std::atomic<int64_t> table_hits_;
+    std::atomic<int64_t> table_lookups_;
+    int last_nodes_;
+    double last_root_value_;
+
+    void poolLoop(int thread_index);
+    void search(int thread_index);
+    uint32_t expand(uint32_t node, mjData* data);
+    double rollout(uint32_t node, mjData* data, std::mt19937& rng) const;
+    int selectChild(const Node& node, uint32_t first) const;
+
+    void restore(const double* state, mjData* data) const;
+    void capture(const mjData* data, double* state) const;
+    double stepReward(const mjData* data) const;
+    bool isTerminal(const mjData* data) const;
+
+    Stats* lookup(const double* state);
+    uint64_t hashState(const double* state) const;
+};
+
+#endif // MCTS_AGENT_H
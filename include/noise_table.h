@@ -0,0 +1,32 @@
+#ifndef NOISE_TABLE_H
+#define NOISE_TABLE_H
+
+#include "aligned_buffer.h"
+#include <cstddef>
+#include <random>
+
+/**
+ * Large read-only table of standard normal samples shared by all ES workers.
+ *
+ * A perturbation of a d-dimensional parameter vector is the slice
+ * [index, index + d), so workers exchange indices instead of sampling or
+ * sending noise vectors. The content depends only on (size, seed), not on
+ * the number of threads used to generate it.
+ */
+class NoiseTable {
+public:
+    NoiseTable(size_t size, unsigned int seed, int num_threads = 0);
+
+    const float* data() const { return noise_.data(); }
+    size_t size() const { return noise_.size(); }
+
+    // Random start index of a slice of length dim
+    size_t sampleIndex(std::mt19937& rng, size_t dim) const;
+
+    const float* slice(size_t index) const { return noise_.data() + index; }
+
+private:
+    AlignedVector<float> noise_;
+};
+
+#endif // NOISE_TABLE_H
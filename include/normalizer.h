@@ -0,0 +1,168 @@
+#ifndef NORMALIZER_H
+#define NORMALIZER_H
+
+#include "environment.h"
+#include "aligned_buffer.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class CheckpointWriter;
+class MappedCheckpoint;
+
+/**
+ * Running mean/variance (Welford), mergeable with Chan et al.'s parallel
+ * combination rule so partial statistics from many threads can be summed.
+ */
+class RunningStats {
+public:
+    explicit RunningStats(int dim = 0);
+
+    void update(const double* x);
+    // n samples stored row-major (n x dim); two-pass batch moments, then merge
+    void updateBatch(const double* xs, int n);
+    void merge(const RunningStats& other);
+    void clear();
+
+    int dim() const { return static_cast<int>(mean_.size()); }
+    double count() const { return count_; }
+    const std::vector<double>& mean() const { return mean_; }
+    const std::vector<double>& m2() const { return m2_; }
+    double variance(int i) const { return count_ > 1.0 ? m2_[i] / count_ : 1.0; }
+
+    void assign(double count, const double* mean, const double* m2);
+
+private:
+    double count_;
+    std::vector<double> mean_;
+    std::vector<double> m2_;
+    std::vector<double> scratch_;
+};
+
+class NormalizerWorker;
+
+/**
+ * Observation and reward normalization shared by parallel workers.
+ *
+ * Each worker accumulates into thread-local statistics and hands deltas to
+ * the normalizer through its own atomic mailbox; sync() drains the mailboxes,
+ * merges and publishes an immutable snapshot that workers pick up on their
+ * next flush. The per-step path touches no shared state.
+ */
+class Normalizer {
+public:
+    struct Config {
+        int obs_dim = 4;
+        double gamma = 0.99;      // Discount for the return used to scale rewards
+        double clip = 10.0;       // Normalized observations are clipped to [-clip, clip]
+        double epsilon = 1e-8;
+        bool normalize_observations = true;
+        bool scale_rewards = true;
+        int max_workers = 64;
+    };
+
+    struct Snapshot {
+        AlignedVector<double> mean;
+        AlignedVector<double> inv_std;
+        double reward_scale = 1.0;
+        double count = 0.0;       // Observations merged into this snapshot
+    };
+
+    explicit Normalizer(const Config& config);
+    ~Normalizer();
+
+    const Config& getConfig() const { return config_; }
+
+    // Create a per-thread worker (up to max_workers alive at once; a destroyed
+    // worker's slot is reused)
+    std::unique_ptr<NormalizerWorker> makeWorker();
+
+    // Merge pending worker deltas and publish a new snapshot. Concurrent
+    // callers do not block: if a sync is already running this returns false.
+    bool sync();
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    // Normalize in place with a given snapshot, without touching statistics
+    void normalize(const Snapshot& snapshot, State& observation) const;
+
+    // Persistence alongside the agent (blobs under "normalizer/")
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(const MappedCheckpoint& checkpoint);
+
+private:
+    friend class NormalizerWorker;
+
+    struct Delta {
+        RunningStats observations;
+        RunningStats returns;
+    };
+
+    struct alignas(kCacheLineSize) Mailbox {
+        std::atomic<Delta*> pending{nullptr};
+        std::atomic<bool> in_use{false};      // Owned by a live worker
+    };
+
+    Config config_;
+    std::unique_ptr<Mailbox[]> mailboxes_;
+    mutable std::atomic_flag syncing_ = ATOMIC_FLAG_INIT;  // Also held while saving
+
+    // Global statistics, only touched while holding syncing_
+    RunningStats observations_;
+    RunningStats returns_;
+
+    std::shared_ptr<const Snapshot> snapshot_;
+
+    void post(int slot, Delta* delta);
+    void releaseSlot(int slot);
+    void publish();
+};
+
+/**
+ * Thread-local normalization stage between Environment::step and Agent::act.
+ * Must not outlive the Normalizer that created it.
+ */
+class NormalizerWorker {
+public:
+    ~NormalizerWorker();
+
+    // Record (if updating) and normalize an observation in place; throws if
+    // it has fewer than obs_dim entries
+    void normalizeObservation(State& observation);
+
+    // Record the discounted return (if updating) and return the scaled reward
+    double scaleReward(Reward reward, Done done);
+
+    // Hand local statistics to the normalizer and pick up the latest snapshot
+    void flush();
+
+    // Restart the discounted return (also for truncated episodes) and flush
+    void endEpisode();
+
+    // Frozen workers normalize without changing statistics (evaluation)
+    void setUpdating(bool updating) { updating_ = updating; }
+
+private:
+    friend class Normalizer;
+    NormalizerWorker(Normalizer* parent, int slot);
+
+    static constexpr int kBatchRows = 64;
+
+    Normalizer* parent_;
+    int slot_;
+    bool updating_;
+    int dim_;
+
+    std::shared_ptr<const Normalizer::Snapshot> snapshot_;
+    std::unique_ptr<Normalizer::Delta> delta_;
+
+    // Observations are buffered so statistics update in vectorized batches
+    std::vector<double> batch_;
+    int batch_rows_;
+
+    double discounted_return_;
+
+    void flushBatch();
+};
+
+#endif // NORMALIZER_H
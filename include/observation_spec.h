@@ -0,0 +1,103 @@
+#ifndef OBSERVATION_SPEC_H
+#define OBSERVATION_SPEC_H
+
+#include <string>
+#include <vector>
+#include "mujoco/mujoco.h"
+
+/**
+ * Declarative observation layout, e.g.
+ *
+ *   ObservationSpec().qpos(0).qvel(0).sinCos(1).qvel(1).history(4)
+ *
+ * Features are written in the order they are declared. history(k) stacks
+ * the last k frames, newest first. A spec is model independent; an
+ * ObservationPipeline resolves it against a model.
+ */
+class ObservationSpec {
+public:
+    enum class Source {
+        Sensor,     // All sensordata values of a named sensor
+        Qpos,       // qpos[index]
+        Qvel,       // qvel[index]
+        SinCos,     // sin(qpos[index]), cos(qpos[index]); continuous for unwrapped angles
+        Energy      // Potential + kinetic energy (needs <flag energy="enable"/>)
+    };
+
+    struct Feature {
+        Source source;
+        int index;
+        std::string name;
+    };
+
+    ObservationSpec& sensor(const std::string& name);
+    ObservationSpec& qpos(int index);
+    ObservationSpec& qvel(int index);
+    ObservationSpec& sinCos(int qpos_index);
+    ObservationSpec& energy();
+    ObservationSpec& history(int frames);
+
+    const std::vector<Feature>& features() const { return features_; }
+    int historyLength() const { return history_; }
+
+    // [q0, v0, q1, v1, ...] for every scalar joint: [x, x_dot, theta, theta_dot] for CartPole
+    static ObservationSpec jointState(const mjModel* model);
+    // Same layout from the jointpos/jointvel sensors of mujoco/cartpole.xml
+    static ObservationSpec cartPoleSensors();
+    // [x, x_dot, sin(theta), cos(theta), theta_dot] for swing-up learners
+    static ObservationSpec swingUp();
+
+private:
+    std::vector<Feature> features_;
+    int history_ = 1;
+};
+
+/**
+ * A spec compiled to a flat list of reads from mjData.
+ *
+ * Copies of adjacent values from the same array are merged, so a run of
+ * sensors or joints costs one memcpy. Frames are written straight into the
+ * caller's buffer; push() shifts a stacked buffer in place.
+ */
+class ObservationPipeline {
+public:
+    ObservationPipeline(const ObservationSpec& spec, const mjModel* model);
+
+    int frameSize() const { return frame_size_; }
+    int size() const { return frame_size_ * history_; }
+
+    // True if any feature reads sensordata or energy, which are only
+    // current after mj_forward / mj_step1 (mj_step leaves them one step behind)
+    bool needsForwardQuantities() const { return needs_forward_; }
+
+    // One frame into out[0, frameSize())
+    void write(const mjData* data, double* out) const;
+    // Fill every history slot with the current frame (episode start)
+    void reset(const mjData* data, double* stacked) const;
+    // Drop the oldest frame of a stacked buffer and write the newest in front
+    void push(const mjData* data, double* stacked) const;
+
+    const std::vector<double>& low() const { return low_; }
+    const std::vector<double>& high() const { return high_; }
+
+private:
+    enum class OpKind { Copy, SinCos, Energy };
+
+    struct Op {
+        OpKind kind;
+        mjtNum* mjData::* field;
+        int address;
+        int count;
+    };
+
+    std::vector<Op> ops_;
+    int frame_size_;
+    int history_;
+    bool needs_forward_;
+    std::vector<double> low_;
+    std::vector<double> high_;
+
+    void addCopy(mjtNum* mjData::* field, int address, int count);
+};
+
+#endif // OBSERVATION_SPEC_H
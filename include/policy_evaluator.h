@@ -0,0 +1,88 @@
+#ifndef POLICY_EVALUATOR_H
+#define POLICY_EVALUATOR_H
+
+#include "environment.h"
+#include "agent.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Evaluates a frozen policy on many environments in parallel.
+ *
+ * Episodes run on per-thread (environment, agent clone) pairs that stay
+ * busy for the whole evaluation. Every round_size episodes a bootstrap
+ * confidence interval of the mean return is computed, and evaluation stops
+ * once the interval is tight enough. compare() also stops once the
+ * difference to the baseline is decided. That test runs at no more than
+ * max_baseline_looks evenly spaced checks and its level is Bonferroni-
+ * corrected over them, so the overall false-decision rate stays within
+ * 1 - confidence; its bootstrap is enlarged until the corrected tails hold
+ * enough resamples to be resolved. An exception thrown by an episode stops
+ * the evaluation and is rethrown to the caller.
+ */
+class PolicyEvaluator {
+public:
+    using EnvironmentFactory = std::function<std::unique_ptr<Environment>()>;
+
+    struct Config {
+        int num_threads = 0;              // 0 = hardware concurrency
+        int max_steps = 1000;             // Per episode
+        int min_episodes = 10;            // Never stop before this many
+        int round_size = 0;               // Episodes between stopping checks, 0 = 2 * threads
+        double confidence = 0.95;
+        int bootstrap_samples = 2000;
+        int max_baseline_looks = 10;      // compare() tests the difference at most this often
+        double target_half_width = 0.0;   // Stop once the CI half-width is below this (0 = off)
+        unsigned int base_seed = 1;       // Episode i uses base_seed + i unless seeds are given
+        unsigned int bootstrap_seed = 12345;
+    };
+
+    struct Result {
+        std::vector<double> returns;      // Completed episodes, indexed by episode
+        int episodes = 0;
+        double mean = 0.0;
+        double ci_low = 0.0;
+        double ci_high = 0.0;
+        // Only set by compare(): CI of mean(agent) - mean(baseline) at the corrected level
+        bool has_baseline = false;
+        double diff_low = 0.0;
+        double diff_high = 0.0;
+        bool stopped_early = false;
+        std::string stop_reason;
+    };
+
+    PolicyEvaluator(EnvironmentFactory factory, const Config& config);
+
+    // Evaluate up to n_episodes; seeds (if given) must hold n_episodes entries
+    Result evaluate(const Agent& agent, int n_episodes,
+                    const std::vector<unsigned int>& seeds = {}) const;
+
+    // As evaluate(), but stops once the difference to the baseline returns is decided
+    Result compare(const Agent& agent, const std::vector<double>& baseline_returns,
+                   int n_episodes, const std::vector<unsigned int>& seeds = {}) const;
+
+    static void printResult(const Result& result);
+
+    // Percentile bootstrap CI of the mean; throws unless each tail holds at least one resample
+    static std::pair<double, double> bootstrapInterval(const std::vector<double>& samples,
+                                                       double confidence, int resamples,
+                                                       unsigned int seed);
+
+    // Percentile bootstrap CI of mean(a) - mean(b), independent samples
+    static std::pair<double, double> bootstrapDifference(const std::vector<double>& a,
+                                                         const std::vector<double>& b,
+                                                         double confidence, int resamples,
+                                                         unsigned int seed);
+
+private:
+    EnvironmentFactory factory_;
+    Config config_;
+
+    Result run(const Agent& agent, const std::vector<double>* baseline, int n_episodes,
+               const std::vector<unsigned int>& seeds) const;
+};
+
+#endif // POLICY_EVALUATOR_H
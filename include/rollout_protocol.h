@@ -0,0 +1,198 @@
+#ifndef ROLLOUT_PROTOCOL_H
+#define ROLLOUT_PROTOCOL_H
+
+#include "environment.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Binary protocol between rollout workers and a coordinator.
+ *
+ * Every message is a MessageHeader followed by payload_bytes of payload,
+ * in host byte order (workers and coordinator run the same build):
+ *
+ *   Hello            worker -> coordinator  HelloMessage
+ *   Policy           coordinator -> worker  PolicyHeader, float parameters[]
+ *   TrajectoryChunk  worker -> coordinator  ChunkHeader, then the arrays
+ *                                           float observations[steps][obs]
+ *                                           float actions[steps]
+ *                                           float rewards[steps]
+ *                                           float episode_returns[episodes]
+ *                                           uint8 dones[steps]
+ *   Shutdown         coordinator -> worker  empty
+ *
+ * Workers never wait for a policy after the first one: they keep stepping
+ * with the latest parameters they have and tag each chunk with the policy
+ * version that produced it.
+ */
+constexpr uint32_t kRolloutMagic = 0x4F525043;  // "CPRO"
+constexpr uint16_t kRolloutVersion = 2;
+constexpr uint32_t kMaxMessageBytes = 256u << 20;
+
+enum class MessageType : uint16_t {
+    Hello = 1,
+    Policy = 2,
+    TrajectoryChunk = 3,
+    Shutdown = 4
+};
+
+struct MessageHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t payload_bytes;
+    uint32_t reserved;
+};
+
+struct HelloMessage {
+    uint32_t worker_id;
+    uint32_t pid;
+    uint32_t observation_size;
+    uint32_t reserved;
+};
+
+// Parameters of an ESAgent with the given shape
+struct PolicyHeader {
+    uint64_t version;
+    uint32_t num_parameters;
+    int32_t observation_size;
+    int32_t hidden_size;
+    int32_t angle_index;
+    double max_force;
+};
+
+struct ChunkHeader {
+    uint64_t policy_version;
+    uint32_t worker_id;
+    uint32_t num_steps;
+    uint32_t observation_size;
+    uint32_t num_episodes;      // Episodes completed within this chunk
+};
+
+struct Message {
+    MessageType type;
+    std::vector<uint8_t> payload;
+};
+
+void encodePolicy(const PolicyHeader& header, const float* parameters, std::vector<uint8_t>& out);
+
+struct PolicyView {
+    PolicyHeader header;
+    const float* parameters;
+};
+
+// Views point into message.payload; throws on malformed payloads
+PolicyView decodePolicy(const Message& message);
+
+struct TrajectoryChunkView {
+    ChunkHeader header;
+    const float* observations;
+    const float* actions;
+    const float* rewards;
+    const float* episode_returns;
+    const uint8_t* dones;
+};
+
+TrajectoryChunkView decodeChunk(const Message& message);
+
+/**
+ * Accumulates a worker's steps until they are sent as one chunk.
+ */
+class TrajectoryChunkBuilder {
+public:
+    TrajectoryChunkBuilder(uint32_t worker_id, int observation_size);
+
+    void add(const State& state, Action action, Reward reward, bool done);
+    void addEpisodeReturn(double episode_return);
+    size_t numSteps() const { return actions_.size(); }
+
+    // Serialize the buffered steps tagged with policy_version, then clear
+    void finish(uint64_t policy_version, std::vector<uint8_t>& out);
+
+private:
+    uint32_t worker_id_;
+    int observation_size_;
+    std::vector<float> observations_;
+    std::vector<float> actions_;
+    std::vector<float> rewards_;
+    std::vector<float> episode_returns_;
+    std::vector<uint8_t> dones_;
+};
+
+/**
+ * "unix:/path/to/socket", "host:port" or "tcp://host:port".
+ */
+struct Endpoint {
+    bool is_unix = false;
+    std::string host;
+    uint16_t port = 0;
+    std::string path;
+
+    static Endpoint parse(const std::string& text);
+    std::string toString() const;
+};
+
+/**
+ * Framed message stream over a connected stream socket.
+ *
+ * send() blocks until the whole frame is written. Reading is either
+ * blocking (receive) or incremental for poll() loops: pump() drains what the
+ * socket has without blocking and pop() returns buffered complete frames.
+ */
+class Connection {
+public:
+    explicit Connection(int fd);
+    ~Connection();
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    static std::unique_ptr<Connection> connect(const Endpoint& endpoint);
+
+    int fd() const { return fd_; }
+
+    void send(MessageType type, const void* payload, size_t bytes);
+    void send(MessageType type, const std::vector<uint8_t>& payload) {
+        send(type, payload.data(), payload.size());
+    }
+
+    // Blocks until a message arrives; false once the peer has closed
+    bool receive(Message& message);
+
+    // Non-blocking read of available bytes; false once the peer has closed
+    bool pump();
+    bool pop(Message& message);
+
+private:
+    int fd_;
+    std::vector<uint8_t> in_;
+    size_t in_start_;
+
+    bool readSome(bool blocking);
+};
+
+/**
+ * Listening socket; removes its Unix socket file on destruction.
+ */
+class Listener {
+public:
+    explicit Listener(const Endpoint& endpoint);
+    ~Listener();
+
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    int fd() const { return fd_; }
+    // Bound endpoint (with the actual port when listening on port 0)
+    const Endpoint& endpoint() const { return endpoint_; }
+
+    std::unique_ptr<Connection> accept();
+
+private:
+    int fd_;
+    Endpoint endpoint_;
+};
+
+#endif // ROLLOUT_PROTOCOL_H
@@ -15,6 +15,7 @@ public:
     // Agent interface implementation
     Action act(const State& state) override;
     void learn(const Experience& experience) override;
+    std::unique_ptr<Agent> clone() const override;
     
     // Agent metadata
     std::string getName() const override { return "RuleBasedAgent"; }
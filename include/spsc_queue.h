@@ -0,0 +1,72 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "aligned_buffer.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ *
+ * Head and tail live on separate cache lines and each side caches the
+ * other's index, so a push or pop touches shared state only when the
+ * cached view says the queue looks full or empty.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity + 1) {
+            size *= 2;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    // Producer side; false when full
+    bool push(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) & mask_;
+        if (next == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (next == cached_head_) {
+                return false;
+            }
+        }
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when empty
+    bool pop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        value = slots_[head];
+        head_.store((head + 1) & mask_, std::memory_order_release);
+        return true;
+    }
+
+    // Either side; exact only when the other side is idle
+    bool empty() const {
+        return head_.load(std::memory_order_seq_cst) == tail_.load(std::memory_order_seq_cst);
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;          // Consumer's view of tail_
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;          // Producer's view of head_
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,136 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "aligned_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Named counters and gauges that hot loops update without locks.
+ *
+ * A counter is split into cache-line sized shards and each thread adds to
+ * its own shard, so concurrent increments never share a line. Readers sum
+ * the shards. Metrics are registered once (under a mutex) and the returned
+ * references stay valid for the lifetime of the registry.
+ */
+class Telemetry {
+public:
+    static constexpr int kShards = 32;
+
+    class Counter {
+    public:
+        void add(uint64_t n = 1) {
+            shards_[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+        }
+        uint64_t value() const;
+
+    private:
+        struct alignas(kCacheLineSize) Shard {
+            std::atomic<uint64_t> value{0};
+        };
+        Shard shards_[kShards];
+    };
+
+    class Gauge {
+    public:
+        void set(double value) { value_.store(value, std::memory_order_relaxed); }
+        double value() const { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        alignas(kCacheLineSize) std::atomic<double> value_{0.0};
+    };
+
+    enum class Type { Counter, Gauge };
+
+    struct Sample {
+        std::string name;
+        std::string help;
+        Type type;
+        double value;
+        uint64_t count;   // Exact value of a counter, 0 for gauges
+    };
+
+    // Process-wide registry used by the framework's own instrumentation
+    static Telemetry& global();
+
+    // Returns the existing metric if the name is already registered
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+
+    // Current value of every metric, in registration order
+    std::vector<Sample> collect() const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        Type type;
+        Counter* counter;
+        Gauge* gauge;
+    };
+
+    mutable std::mutex mutex_;
+    std::deque<Counter> counters_;
+    std::deque<Gauge> gauges_;
+    std::vector<Entry> entries_;
+
+    static int shardIndex();
+};
+
+/**
+ * Background thread that samples a registry at a fixed interval, derives
+ * per-second rates from counters and publishes the result in Prometheus
+ * text format over HTTP (GET /metrics) and/or to a file that is replaced
+ * atomically. Nothing here runs on the threads that update metrics.
+ */
+class TelemetryExporter {
+public:
+    struct Config {
+        double interval_seconds = 1.0;
+        int http_port = 0;                     // 0 = no HTTP endpoint
+        std::string http_address = "127.0.0.1";
+        std::string file_path;                 // Empty = no file
+    };
+
+    TelemetryExporter(Telemetry& telemetry, const Config& config);
+    ~TelemetryExporter();
+
+    TelemetryExporter(const TelemetryExporter&) = delete;
+    TelemetryExporter& operator=(const TelemetryExporter&) = delete;
+
+    // Bound HTTP port (useful with http_port = -1 for an ephemeral port)
+    int httpPort() const { return bound_port_; }
+
+    // Latest rendered exposition
+    std::string latest() const;
+
+    // Render samples plus "<counter>_per_second" rates over elapsed_seconds
+    static std::string renderPrometheus(const std::vector<Telemetry::Sample>& samples,
+                                        const std::map<std::string, double>& previous,
+                                        double elapsed_seconds);
+
+private:
+    Telemetry& telemetry_;
+    Config config_;
+    int listen_fd_;
+    int bound_port_;
+
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    mutable std::mutex text_mutex_;
+    std::string text_;
+
+    void run();
+    void sample(std::map<std::string, double>& previous, double elapsed_seconds);
+    void serve(int client_fd) const;
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,145 @@
+#ifndef TILE_CODING_AGENT_H
+#define TILE_CODING_AGENT_H
+
+#include "agent.h"
+#include "aligned_buffer.h"
+#include "telemetry.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+/**
+ * Tile coder over the 4-D CartPole state [x, x_dot, theta, theta_dot].
+ * Each tiling is offset asymmetrically and maps a state to one tile, so a
+ * state activates exactly num_tilings features in a dense flat index space.
+ */
+class TileCoder {
+public:
+    static constexpr int kStateDim = 4;
+
+    struct Config {
+        int num_tilings = 8;          // Power of two >= 2 * kStateDim works best
+        int tiles_per_dim = 10;
+        std::array<double, kStateDim> low = {-2.4, -5.0, -M_PI, -15.0};
+        std::array<double, kStateDim> high = {2.4, 5.0, M_PI, 15.0};
+        int angle_dim = 2;            // Wrapped into [low, high); -1 disables wrapping
+    };
+
+    explicit TileCoder(const Config& config);
+
+    // Write num_tilings feature indices for the given state into out
+    void features(const State& state, int* out) const;
+
+    int numTilings() const { return config_.num_tilings; }
+    int numFeatures() const { return num_features_; }
+
+private:
+    Config config_;
+    int num_features_;
+    std::array<double, kStateDim> inv_width_;
+    std::array<int, kStateDim> stride_;
+    std::vector<double> offsets_;    // [dim][tiling], in tile units
+    std::vector<int> tiling_base_;   // First feature index of each tiling
+};
+
+/**
+ * Linear SARSA(lambda) / Watkins Q(lambda) agent on tile-coded features.
+ * Forces are discretized into evenly spaced actions in [-max_force, max_force];
+ * with num_actions = 2 this is the bang-bang action set.
+ */
+class TileCodingAgent : public Agent {
+public:
+    enum class Algorithm { SARSA, QLearning };
+
+    struct Config {
+        TileCoder::Config tiles;
+        Algorithm algorithm = Algorithm::SARSA;
+        int num_actions = 3;
+        double max_force = 10.0;
+        double alpha = 0.1;           // Step size, divided across tilings
+        double gamma = 0.99;
+        double lambda = 0.9;
+        double epsilon = 0.1;
+        double epsilon_decay = 0.995; // Applied once per episode
+        double min_epsilon = 0.01;
+        double min_trace = 0.01;      // Traces below this are dropped
+        unsigned int seed = 0;
+        bool telemetry = true;        // Count updates in Telemetry::global()
+    };
+
+    TileCodingAgent();
+    explicit TileCodingAgent(const Config& config);
+    ~TileCodingAgent() override = default;
+
+    // Agent interface implementation
+    Action act(const State& state) override;
+    void learn(const Experience& experience) override;
+    void reset() override;
+    void setTrainingMode(bool training) override;
+    std::unique_ptr<Agent> clone() const override;
+
+    // Agent metadata
+    std::string getName() const override { return "TileCodingAgent"; }
+    std::string getDescription() const override {
+        return "Linear SARSA(lambda)/Q(lambda) on tile-coded CartPole state";
+    }
+
+    // Get learning statistics
+    std::vector<std::pair<std::string, double>> getStats() const override;
+
+protected:
+    // Checkpoint hooks (weights, exploration schedule, RNG)
+    void saveState(CheckpointWriter& writer) const override;
+    void loadState(const std::shared_ptr<const MappedCheckpoint>& checkpoint) override;
+
+private:
+    struct Trace {
+        int32_t weight;
+        float value;
+    };
+
+    Config config_;
+    TileCoder coder_;
+    int num_actions_;
+    std::vector<double> actions_;
+
+    // Weights laid out [feature][action] so Q(s, .) reads num_tilings short rows.
+    // Reads go through weight_view_, which points either at weights_ or, for a
+    // frozen agent, straight into a mapped checkpoint.
+    AlignedVector<float> weights_;
+    const float* weight_view_;
+    std::shared_ptr<const MappedCheckpoint> mapped_;
+
+    // Sparse replacing traces plus a dense weight -> slot map for O(1) lookup
+    std::vector<Trace> traces_;
+    std::vector<int32_t> trace_slot_;
+
+    // Scratch buffers reused across steps
+    std::vector<int> features_;
+    std::vector<int> next_features_;
+    std::vector<double> q_values_;
+
+    // Action chosen while bootstrapping on next_state (coded in next_features_),
+    // returned by the next act() if it codes to the same tiles; -1 = none
+    int pending_action_;
+
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> uniform_dist_;
+    double epsilon_;
+
+    // Statistics
+    int64_t total_updates_;
+    double last_td_error_;
+    Telemetry::Counter* updates_total_;
+
+    void actionValues(const int* features, double* q) const;
+    int greedyAction(const double* q) const;
+    int selectAction(const double* q);
+    int actionIndex(Action action) const;
+    void setTrace(int32_t weight);
+    void decayTraces(double factor);
+    void clearTraces();
+};
+
+#endif // TILE_CODING_AGENT_H
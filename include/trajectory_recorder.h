@@ -0,0 +1,116 @@
+#ifndef TRAJECTORY_RECORDER_H
+#define TRAJECTORY_RECORDER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "mujoco/mujoco.h"
+
+/**
+ * Compact binary recording of qpos/qvel/ctrl per step.
+ *
+ * File:    TrajectoryFileHeader, then one block per episode
+ * Block:   TrajectoryEpisodeHeader, then payload_bytes of encoded frames
+ * Frame:   nq + nv + nu values, each quantized to a multiple of `quantum`,
+ *          stored as a zigzag varint delta against the previous frame
+ *          (the first frame of an episode is a delta against zero)
+ *
+ * Slowly changing CartPole state encodes to a few bytes per value, and an
+ * episode is written as one block when it ends.
+ */
+constexpr uint32_t kTrajectoryMagic = 0x52545043;  // "CPTR"
+constexpr uint32_t kTrajectoryEpisodeMagic = 0x53495045;  // "EPIS"
+constexpr uint32_t kTrajectoryVersion = 1;
+
+struct TrajectoryFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nq;
+    uint32_t nv;
+    uint32_t nu;
+    uint32_t reserved;
+    double timestep;
+    double quantum;
+};
+
+struct TrajectoryEpisodeHeader {
+    uint32_t magic;
+    uint32_t num_frames;
+    uint64_t payload_bytes;
+};
+
+/**
+ * Appends episodes to a trajectory file. One recorder per environment;
+ * not thread-safe.
+ */
+class TrajectoryRecorder {
+public:
+    TrajectoryRecorder(const std::string& filepath, const mjModel* model, double quantum = 1e-6);
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    // Ends any episode in progress and starts a new one
+    void beginEpisode();
+    void record(const mjData* data);
+    void endEpisode();
+
+    long long framesRecorded() const { return total_frames_; }
+
+private:
+    std::ofstream file_;
+    int nq_;
+    int nv_;
+    int nu_;
+    double inv_quantum_;
+
+    std::vector<int64_t> previous_;
+    std::vector<uint8_t> buffer_;
+    uint32_t episode_frames_;
+    bool in_episode_;
+    long long total_frames_;
+
+    void encode(const double* values, int count, int64_t* previous);
+};
+
+/**
+ * Read side: maps the file read-only, indexes the episode blocks in place
+ * and decodes them on demand, so very large recordings can be browsed
+ * without reading them into memory.
+ */
+class TrajectoryFile {
+public:
+    explicit TrajectoryFile(const std::string& filepath);
+    ~TrajectoryFile();
+
+    TrajectoryFile(const TrajectoryFile&) = delete;
+    TrajectoryFile& operator=(const TrajectoryFile&) = delete;
+
+    int nq() const { return header_.nq; }
+    int nv() const { return header_.nv; }
+    int nu() const { return header_.nu; }
+    int frameSize() const { return header_.nq + header_.nv + header_.nu; }
+    double timestep() const { return header_.timestep; }
+
+    int numEpisodes() const { return static_cast<int>(episodes_.size()); }
+    int numFrames(int episode) const { return episodes_[episode].num_frames; }
+
+    // Decode an episode into frames laid out [qpos | qvel | ctrl] per frame
+    void decodeEpisode(int episode, std::vector<double>& frames) const;
+
+private:
+    struct EpisodeIndex {
+        uint64_t offset;
+        uint64_t payload_bytes;
+        uint32_t num_frames;
+    };
+
+    TrajectoryFileHeader header_;
+    const uint8_t* data_;
+    size_t size_;
+    std::vector<EpisodeIndex> episodes_;
+};
+
+#endif // TRAJECTORY_RECORDER_H
@@ -0,0 +1,101 @@
+#ifndef VECTOR_ENV_H
+#define VECTOR_ENV_H
+
+#include "cartpole_env.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A batch of CartPoleEnvs stepped together with automatic reset.
+ *
+ * step() advances every environment once. An environment that finishes is
+ * reset automatically, so its observation row always belongs to a running
+ * episode; the last observation of the finished episode is kept in
+ * finalObservations() for bootstrapping truncated episodes.
+ *
+ * With background_reset, finished environments are handed to a reset
+ * thread through an SPSC queue and step() returns without waiting for
+ * them. Their rows become valid once the reset is done: observation(i)
+ * waits for environment i only, observations() for all of them, and the
+ * next step() for each environment just before stepping it. Reading rows
+ * in order with observation(i) lets resets overlap with the caller's
+ * action selection as well as with stepping.
+ */
+class VectorCartPoleEnv {
+public:
+    struct Config {
+        int num_envs = 8;
+        bool background_reset = true;
+        unsigned int seed = 0;         // Environment i is seeded with seed + i
+    };
+
+    VectorCartPoleEnv(const mjModel* base_model, const Config& config);
+    ~VectorCartPoleEnv();
+
+    VectorCartPoleEnv(const VectorCartPoleEnv&) = delete;
+    VectorCartPoleEnv& operator=(const VectorCartPoleEnv&) = delete;
+
+    int size() const { return static_cast<int>(envs_.size()); }
+    int observationSize() const { return observation_size_; }
+
+    // Individual environments, e.g. for setInitialStatePool (configure before reset(),
+    // which throws unless all observation specs give the same size);
+    // waits for a background reset of environment i
+    CartPoleEnv& env(int i) {
+        waitForReset(i);
+        return *envs_[i];
+    }
+
+    // Reset every environment; returns observations [num_envs][observation_size]
+    const double* reset();
+    // Step environment i with actions[i], resetting the ones that finish
+    void step(const Action* actions);
+
+    // Row i of the observations, once environment i is not being reset
+    const double* observation(int i) const {
+        waitForReset(i);
+        return observations_.data() + static_cast<size_t>(i) * observation_size_;
+    }
+    // All observations [num_envs][observation_size], waiting for every pending reset
+    const double* observations() const;
+    const double* finalObservations() const { return final_observations_.data(); }
+    const double* rewards() const { return rewards_.data(); }
+    // Episode ended this step (terminated or time limit), and which of the two
+    const uint8_t* dones() const { return dones_.data(); }
+    const uint8_t* truncated() const { return truncated_.data(); }
+
+    long long episodesCompleted() const { return episodes_; }
+
+private:
+    Config config_;
+    std::vector<std::unique_ptr<CartPoleEnv>> envs_;
+    int observation_size_;
+
+    std::vector<double> observations_;
+    std::vector<double> final_observations_;
+    std::vector<double> rewards_;
+    std::vector<uint8_t> dones_;
+    std::vector<uint8_t> truncated_;
+    long long episodes_;
+
+    // Background reset: the stepping thread produces indices, the reset thread consumes them
+    SpscQueue<int> reset_queue_;
+    std::unique_ptr<std::atomic<bool>[]> reset_ready_;
+    std::atomic<bool> running_;
+    std::atomic<bool> sleeping_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread reset_thread_;
+
+    void resetEnv(int i);
+    void waitForReset(int i) const;
+    void resetLoop();
+};
+
+#endif // VECTOR_ENV_H
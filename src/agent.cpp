@@ -0,0 +1,28 @@
+#include "agent.h"
+#include "checkpoint.h"
+#include "normalizer.h"
+#include <stdexcept>
+
+void Agent::saveModel(const std::string& filepath) const {
+    CheckpointWriter writer(getName());
+    saveState(writer);
+    if (normalizer_) {
+        normalizer_->saveState(writer);
+    }
+    writer.commit(filepath);
+}
+
+void Agent::loadModel(const std::string& filepath) {
+    loadModel(MappedCheckpoint::open(filepath));
+}
+
+void Agent::loadModel(const std::shared_ptr<const MappedCheckpoint>& checkpoint) {
+    if (checkpoint->agentName() != getName()) {
+        throw std::runtime_error("Checkpoint was written by " + checkpoint->agentName() +
+                                 ", not " + getName());
+    }
+    loadState(checkpoint);
+    if (normalizer_ && checkpoint->has("normalizer/obs_mean")) {
+        normalizer_->loadState(*checkpoint);
+    }
+}
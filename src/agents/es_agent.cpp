@@ -0,0 +1,209 @@
+#include "../include/es_agent.h"
+#include "../include/checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+ESAgent::ESAgent() : ESAgent(Config()) {
+}
+
+ESAgent::ESAgent(const Config& config)
+    : config_(config), input_size_(config.observation_size + (config.angle_index >= 0 ? 1 : 0)),
+      adam_steps_(0), last_update_norm_(0.0) {
+    if (config_.observation_size <= 0 || config_.hidden_size < 0 ||
+        config_.angle_index >= config_.observation_size) {
+        throw std::invalid_argument("Invalid ESAgent configuration");
+    }
+
+    const int in = input_size_;
+    const int h = config_.hidden_size;
+    params_.assign(h > 0 ? static_cast<size_t>(h) * (in + 2) + 1 : in + 1, 0.0f);
+    adam_m_.assign(params_.size(), 0.0f);
+    adam_v_.assign(params_.size(), 0.0f);
+    scratch_.resize(scratchSize());
+
+    // Fan-in scaled hidden weights; output weights and biases start at zero
+    if (h > 0) {
+        std::mt19937 rng(config_.seed);
+        std::normal_distribution<float> normal(0.0f, 1.0f / std::sqrt(static_cast<float>(in)));
+        for (int i = 0; i < h * in; ++i) {
+            params_[i] = normal(rng);
+        }
+    }
+}
+
+void ESAgent::encodeInput(const State& state, float* input) const {
+    int k = 0;
+    for (int i = 0; i < config_.observation_size; ++i) {
+        if (i == config_.angle_index) {
+            input[k++] = static_cast<float>(std::sin(state[i]));
+            input[k++] = static_cast<float>(std::cos(state[i]));
+        } else {
+            input[k++] = static_cast<float>(state[i]);
+        }
+    }
+}
+
+Action ESAgent::policy(const float* params, const State& state, float* scratch) const {
+    if (state.size() < static_cast<size_t>(config_.observation_size)) {
+        return 0.0;
+    }
+
+    const int in = input_size_;
+    const int h = config_.hidden_size;
+    float* x = scratch;
+    float* hidden = scratch + in;
+    encodeInput(state, x);
+
+    float out;
+    if (h == 0) {
+        out = params[in];
+        for (int j = 0; j < in; ++j) {
+            out += params[j] * x[j];
+        }
+    } else {
+        const float* w1 = params;
+        const float* b1 = w1 + static_cast<size_t>(h) * in;
+        const float* w2 = b1 + h;
+        for (int i = 0; i < h; ++i) {
+            float sum = b1[i];
+            for (int j = 0; j < in; ++j) {
+                sum += w1[i * in + j] * x[j];
+            }
+            hidden[i] = std::tanh(sum);
+        }
+        out = w2[h];
+        for (int i = 0; i < h; ++i) {
+            out += w2[i] * hidden[i];
+        }
+    }
+    return config_.max_force * std::tanh(out);
+}
+
+Action ESAgent::act(const State& state) {
+    return policy(params_.data(), state, scratch_.data());
+}
+
+void ESAgent::actBatch(const State* states, size_t count, Action* actions) {
+    const int in = input_size_;
+    const int h = config_.hidden_size;
+    batch_input_.resize(count * in);
+    batch_output_.resize(count);
+    const float* params = params_.data();
+
+    for (size_t b = 0; b < count; ++b) {
+        if (states[b].size() >= static_cast<size_t>(config_.observation_size)) {
+            encodeInput(states[b], batch_input_.data() + b * in);
+        }
+    }
+
+    // Weight rows are the outer loop so each is read once per batch; the
+    // summation order matches policy(), so results are identical to act()
+    float* out = batch_output_.data();
+    if (h == 0) {
+        for (size_t b = 0; b < count; ++b) {
+            const float* x = batch_input_.data() + b * in;
+            out[b] = params[in];
+            for (int j = 0; j < in; ++j) {
+                out[b] += params[j] * x[j];
+            }
+        }
+    } else {
+        const float* w1 = params;
+        const float* b1 = w1 + static_cast<size_t>(h) * in;
+        const float* w2 = b1 + h;
+        std::fill(out, out + count, w2[h]);
+        for (int i = 0; i < h; ++i) {
+            const float* row = w1 + static_cast<size_t>(i) * in;
+            for (size_t b = 0; b < count; ++b) {
+                const float* x = batch_input_.data() + b * in;
+                float sum = b1[i];
+                for (int j = 0; j < in; ++j) {
+                    sum += row[j] * x[j];
+                }
+                out[b] += w2[i] * std::tanh(sum);
+            }
+        }
+    }
+
+    for (size_t b = 0; b < count; ++b) {
+        actions[b] = states[b].size() >= static_cast<size_t>(config_.observation_size)
+            ? config_.max_force * std::tanh(out[b])
+            : 0.0;
+    }
+}
+
+std::unique_ptr<Agent> ESAgent::clone() const {
+    return std::make_unique<ESAgent>(*this);
+}
+
+void ESAgent::setParameters(const float* params) {
+    std::copy(params, params + params_.size(), params_.begin());
+}
+
+void ESAgent::applyGradient(const float* gradient) {
+    adam_steps_++;
+    const double t = static_cast<double>(adam_steps_);
+    const float lr = static_cast<float>(config_.learning_rate *
+                                        std::sqrt(1.0 - std::pow(config_.beta2, t)) /
+                                        (1.0 - std::pow(config_.beta1, t)));
+    const float b1 = static_cast<float>(config_.beta1);
+    const float b2 = static_cast<float>(config_.beta2);
+    const float eps = static_cast<float>(config_.adam_epsilon);
+    const float decay = static_cast<float>(config_.weight_decay);
+
+    float* params = params_.data();
+    float* m = adam_m_.data();
+    float* v = adam_v_.data();
+    double norm = 0.0;
+    for (size_t i = 0; i < params_.size(); ++i) {
+        float g = gradient[i] - decay * params[i];
+        m[i] = b1 * m[i] + (1.0f - b1) * g;
+        v[i] = b2 * v[i] + (1.0f - b2) * g * g;
+        float delta = lr * m[i] / (std::sqrt(v[i]) + eps);
+        params[i] += delta;
+        norm += static_cast<double>(delta) * delta;
+    }
+    last_update_norm_ = std::sqrt(norm);
+}
+
+void ESAgent::saveState(CheckpointWriter& writer) const {
+    const int32_t shape[] = {config_.observation_size, config_.hidden_size, config_.angle_index};
+
+    writer.setStep(static_cast<uint64_t>(adam_steps_));
+    writer.addCopy("shape", shape, 3);
+    writer.add("parameters", params_.data(), params_.size());
+    writer.add("optimizer/m", adam_m_.data(), adam_m_.size());
+    writer.add("optimizer/v", adam_v_.data(), adam_v_.size());
+    writer.add("optimizer/steps", &adam_steps_, 1);
+}
+
+void ESAgent::loadState(const std::shared_ptr<const MappedCheckpoint>& checkpoint) {
+    BlobView<int32_t> shape = checkpoint->view<int32_t>("shape");
+    BlobView<float> params = checkpoint->view<float>("parameters");
+    if (shape.size != 3 || shape[0] != config_.observation_size ||
+        shape[1] != config_.hidden_size || shape[2] != config_.angle_index ||
+        params.size != params_.size()) {
+        throw std::runtime_error("Checkpoint does not match ESAgent configuration");
+    }
+
+    BlobView<float> m = checkpoint->view<float>("optimizer/m");
+    BlobView<float> v = checkpoint->view<float>("optimizer/v");
+    BlobView<int64_t> steps = checkpoint->view<int64_t>("optimizer/steps");
+    if (m.size != params_.size() || v.size != params_.size() || steps.size != 1) {
+        throw std::runtime_error("Checkpoint optimizer state does not match ESAgent parameters");
+    }
+
+    std::copy(params.begin(), params.end(), params_.begin());
+    std::copy(m.begin(), m.end(), adam_m_.begin());
+    std::copy(v.begin(), v.end(), adam_v_.begin());
+    adam_steps_ = steps[0];
+}
+
+std::vector<std::pair<std::string, double>> ESAgent::getStats() const {
+    return {
+        {"generation", static_cast<double>(adam_steps_)},
+        {"parameters", static_cast<double>(params_.size())},
+        {"last_update_norm", last_update_norm_}
+    };
+}
@@ -0,0 +1,420 @@
+#include "../include/mcts_agent.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+constexpr uint32_t kUnexpanded = 0;      // Node 0 is the root, never anyone's child
+constexpr uint32_t kExpanding = std::numeric_limits<uint32_t>::max();
+
+// Transposition tags: high 48 bits of the state hash, low 16 bits generation
+constexpr uint64_t kGenerationMask = 0xFFFF;
+constexpr uint64_t kClaiming = std::numeric_limits<uint64_t>::max();
+constexpr int kMaxProbes = 16;
+
+void atomicAdd(std::atomic<double>& target, double delta) {
+    double current = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t mix(uint64_t h) {
+    // splitmix64 finalizer
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace
+
+MCTSAgent::MCTSAgent(std::shared_ptr<const mjModel> model) : MCTSAgent(std::move(model), Config()) {
+}
+
+MCTSAgent::MCTSAgent(std::shared_ptr<const mjModel> model, const Config& config)
+    : model_(std::move(model)), config_(config), next_node_(0), generation_(0),
+      search_epoch_(0), pool_busy_(0), pool_stopping_(false), simulations_started_(0), table_hits_(0), table_lookups_(0), last_nodes_(0),
+      last_root_value_(0.0) {
+    if (!model_) {
+        throw std::invalid_argument("MCTSAgent needs a model");
+    }
+    if (model_->nq != model_->nv || model_->nu < 1) {
+        throw std::invalid_argument("MCTSAgent needs scalar joints and an actuator");
+    }
+    if (config_.num_actions < 2 || config_.num_simulations < 1 || config_.max_depth < 1 ||
+        config_.rollout_depth < 0 || config_.virtual_loss < 0 ||
+        config_.max_nodes < 1 + config_.num_actions ||
+        config_.table_size < 1 || (config_.table_size & (config_.table_size - 1)) != 0 ||
+        config_.gamma <= 0.0 || config_.gamma >= 1.0) {
+        throw std::invalid_argument("Invalid MCTSAgent configuration");
+    }
+
+    num_threads_ = config_.num_threads > 0
+        ? config_.num_threads
+        : std::max(1u, std::thread::hardware_concurrency());
+    state_size_ = model_->nq + model_->nv;
+
+    for (int a = 0; a < config_.num_actions; ++a) {
+        actions_.push_back(-config_.max_force + 2.0 * config_.max_force * a / (config_.num_actions - 1));
+    }
+    quantum_.assign(model_->nq, config_.position_quantum);
+    quantum_.insert(quantum_.end(), model_->nv, config_.velocity_quantum);
+
+    for (int t = 0; t < num_threads_; ++t) {
+        mjData* data = mj_makeData(model_.get());
+        if (!data) {
+            for (mjData* d : thread_data_) {
+                mj_deleteData(d);
+            }
+            throw std::runtime_error("Could not allocate mjData for MCTSAgent");
+        }
+        thread_data_.push_back(data);
+    }
+
+    nodes_.reset(new Node[config_.max_nodes]);
+    node_states_.resize(static_cast<size_t>(config_.max_nodes) * state_size_);
+    table_.reset(new TableEntry[config_.table_size]);
+
+    for (int t = 1; t < num_threads_; ++t) {
+        pool_.emplace_back(&MCTSAgent::poolLoop, this, t);
+    }
+}
+
+MCTSAgent::~MCTSAgent() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_stopping_ = true;
+    }
+    pool_wake_.notify_all();
+    for (auto& thread : pool_) {
+        thread.join();
+    }
+    for (mjData* data : thread_data_) {
+        mj_deleteData(data);
+    }
+}
+
+std::unique_ptr<Agent> MCTSAgent::clone() const {
+    return std::make_unique<MCTSAgent>(model_, config_);
+}
+
+Action MCTSAgent::act(const State& state) {
+    if (state.size() < static_cast<size_t>(state_size_)) {
+        return 0.0;
+    }
+
+    // New generation: every table entry from earlier searches is stale.
+    // On wrap-around the table is cleared so old tags cannot match again.
+    generation_ = generation_ % (kGenerationMask - 1) + 1;
+    if (generation_ == 1) {
+        for (int i = 0; i < config_.table_size; ++i) {
+            table_[i].tag.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Root from the joint-state observation [q0, v0, q1, v1, ...]
+    double* root_state = node_states_.data();
+    for (int j = 0; j < model_->nq; ++j) {
+        root_state[j] = state[2 * j];
+        root_state[model_->nq + j] = state[2 * j + 1];
+    }
+    Node& root = nodes_[0];
+    root.children.store(kUnexpanded, std::memory_order_relaxed);
+    root.reward = 0.0f;
+    root.terminal = false;
+    root.stats = &root.own_stats;
+    root.own_stats.visits.store(0, std::memory_order_relaxed);
+    root.own_stats.value_sum.store(0.0, std::memory_order_relaxed);
+    next_node_.store(1, std::memory_order_relaxed);
+    simulations_started_.store(0, std::memory_order_relaxed);
+    table_hits_.store(0, std::memory_order_relaxed);
+    table_lookups_.store(0, std::memory_order_relaxed);
+
+    // Wake the parked helpers, search alongside them, then wait for all to finish
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        search_epoch_++;
+        pool_busy_ = static_cast<int>(pool_.size());
+    }
+    pool_wake_.notify_all();
+    search(0);
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        pool_done_.wait(lock, [&] { return pool_busy_ == 0; });
+    }
+
+    last_nodes_ = static_cast<int>(std::min<uint32_t>(next_node_.load(), config_.max_nodes));
+    int root_visits = root.stats->visits.load();
+    last_root_value_ = root_visits > 0 ? root.stats->value_sum.load() / root_visits : 0.0;
+
+    // Most visited root action
+    uint32_t first = root.children.load(std::memory_order_acquire);
+    if (first == kUnexpanded || first == kExpanding) {
+        return 0.0;
+    }
+    int best = 0;
+    int best_visits = -1;
+    for (int a = 0; a < config_.num_actions; ++a) {
+        int visits = nodes_[first + a].stats->visits.load(std::memory_order_relaxed);
+        if (visits > best_visits) {
+            best_visits = visits;
+            best = a;
+        }
+    }
+    return actions_[best];
+}
+
+void MCTSAgent::poolLoop(int thread_index) {
+    uint64_t seen_epoch = 0;
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    while (true) {
+        pool_wake_.wait(lock, [&] { return pool_stopping_ || search_epoch_ != seen_epoch; });
+        if (pool_stopping_) {
+            return;
+        }
+        seen_epoch = search_epoch_;
+
+        lock.unlock();
+        search(thread_index);
+        lock.lock();
+        if (--pool_busy_ == 0) {
+            pool_done_.notify_one();
+        }
+    }
+}
+
+void MCTSAgent::search(int thread_index) {
+    mjData* data = thread_data_[thread_index];
+    std::mt19937 rng(config_.seed + 7919u * thread_index + 104729u * static_cast<unsigned>(generation_));
+    std::vector<uint32_t> path;
+    path.reserve(config_.max_depth + 1);
+    const int virtual_loss = config_.virtual_loss;
+
+    while (simulations_started_.fetch_add(1, std::memory_order_relaxed) < config_.num_simulations) {
+        // Selection: descend, pre-counting virtual visits so concurrent
+        // threads see this path as already explored
+        path.clear();
+        uint32_t current = 0;
+        path.push_back(current);
+        nodes_[0].stats->visits.fetch_add(virtual_loss, std::memory_order_relaxed);
+
+        double leaf_value = 0.0;
+        for (int depth = 0;; ++depth) {
+            Node& node = nodes_[current];
+            if (node.terminal) {
+                break;
+            }
+
+            uint32_t first = node.children.load(std::memory_order_acquire);
+            bool expanded = false;
+            if (first == kUnexpanded && depth < config_.max_depth) {
+                uint32_t expected = kUnexpanded;
+                if (node.children.compare_exchange_strong(expected, kExpanding,
+                                                          std::memory_order_acquire)) {
+                    first = expand(current, data);
+                    node.children.store(first, std::memory_order_release);
+                    expanded = first != kUnexpanded;
+                } else {
+                    first = expected;
+                }
+            }
+            // Depth limit, full arena, or another thread is expanding it: evaluate here
+            if (first == kUnexpanded || first == kExpanding || depth >= config_.max_depth) {
+                leaf_value = rollout(current, data, rng);
+                break;
+            }
+
+            current = first + selectChild(node, first);
+            nodes_[current].stats->visits.fetch_add(virtual_loss, std::memory_order_relaxed);
+            path.push_back(current);
+
+            // One new level per simulation; the new child is evaluated by rollout
+            if (expanded) {
+                if (!nodes_[current].terminal) {
+                    leaf_value = rollout(current, data, rng);
+                }
+                break;
+            }
+        }
+
+        // Backup: replace the virtual visits with one real one and add the
+        // discounted return seen from each node
+        double value = leaf_value;
+        for (size_t i = path.size(); i-- > 0;) {
+            Node& node = nodes_[path[i]];
+            node.stats->visits.fetch_add(1 - virtual_loss, std::memory_order_relaxed);
+            atomicAdd(node.stats->value_sum, value);
+            value = node.reward + config_.gamma * value;
+        }
+    }
+}
+
+uint32_t MCTSAgent::expand(uint32_t node, mjData* data) {
+    const int n = config_.num_actions;
+    uint32_t first = next_node_.fetch_add(n, std::memory_order_relaxed);
+    if (first + n > static_cast<uint32_t>(config_.max_nodes)) {
+        return kUnexpanded;
+    }
+
+    const double* parent_state = node_states_.data() + static_cast<size_t>(node) * state_size_;
+    for (int a = 0; a < n; ++a) {
+        uint32_t index = first + a;
+        double* child_state = node_states_.data() + static_cast<size_t>(index) * state_size_;
+        restore(parent_state, data);
+        data->ctrl[0] = actions_[a];
+        mj_step(model_.get(), data);
+        capture(data, child_state);
+
+        Node& child = nodes_[index];
+        child.children.store(kUnexpanded, std::memory_order_relaxed);
+        child.reward = static_cast<float>(stepReward(data));
+        child.terminal = isTerminal(data);
+        Stats* shared = lookup(child_state);
+        if (shared) {
+            child.stats = shared;
+        } else {
+            child.own_stats.visits.store(0, std::memory_order_relaxed);
+            child.own_stats.value_sum.store(0.0, std::memory_order_relaxed);
+            child.stats = &child.own_stats;
+        }
+    }
+    return first;
+}
+
+double MCTSAgent::rollout(uint32_t node, mjData* data, std::mt19937& rng) const {
+    if (config_.rollout_depth == 0) {
+        return 0.0;
+    }
+    restore(node_states_.data() + static_cast<size_t>(node) * state_size_, data);
+
+    std::uniform_int_distribution<int> action(0, config_.num_actions - 1);
+    double value = 0.0;
+    double discount = 1.0;
+    for (int k = 0; k < config_.rollout_depth; ++k) {
+        data->ctrl[0] = actions_[action(rng)];
+        mj_step(model_.get(), data);
+        value += discount * stepReward(data);
+        discount *= config_.gamma;
+        if (isTerminal(data)) {
+            break;
+        }
+    }
+    return value;
+}
+
+int MCTSAgent::selectChild(const Node& node, uint32_t first) const {
+    // UCT on returns normalized by the largest possible discounted return
+    const double scale = (1.0 - config_.gamma) / 2.0;
+    const int parent_visits = std::max(1, node.stats->visits.load(std::memory_order_relaxed));
+    const double log_parent = std::log(static_cast<double>(parent_visits));
+
+    int best = 0;
+    double best_score = -std::numeric_limits<double>::infinity();
+    for (int a = 0; a < config_.num_actions; ++a) {
+        const Node& child = nodes_[first + a];
+        int visits = child.stats->visits.load(std::memory_order_relaxed);
+        if (visits <= 0) {
+            return a;
+        }
+        double value = child.terminal ? 0.0
+            : child.stats->value_sum.load(std::memory_order_relaxed) / visits;
+        double q = (child.reward + config_.gamma * value) * scale;
+        double score = q + config_.exploration * std::sqrt(log_parent / visits);
+        if (score > best_score) {
+            best_score = score;
+            best = a;
+        }
+    }
+    return best;
+}
+
+void MCTSAgent::restore(const double* state, mjData* data) const {
+    std::memcpy(data->qpos, state, model_->nq * sizeof(double));
+    std::memcpy(data->qvel, state + model_->nq, model_->nv * sizeof(double));
+    // Planned states never carry actuator activations or warm starts over
+    if (model_->na > 0) {
+        std::memset(data->act, 0, model_->na * sizeof(double));
+    }
+    std::memset(data->qacc_warmstart, 0, model_->nv * sizeof(double));
+    data->time = 0.0;
+}
+
+void MCTSAgent::capture(const mjData* data, double* state) const {
+    std::memcpy(state, data->qpos, model_->nq * sizeof(double));
+    std::memcpy(state + model_->nq, data->qvel, model_->nv * sizeof(double));
+}
+
+double MCTSAgent::stepReward(const mjData* data) const {
+    // Same shaping as CartPoleEnv: mean cos of the absolute link angles, plus one
+    double theta = 0.0;
+    double upright = 0.0;
+    for (int j = 1; j < model_->nq; ++j) {
+        theta += data->qpos[j];
+        upright += std::cos(theta);
+    }
+    return upright / std::max(1, model_->nq - 1) + 1.0;
+}
+
+bool MCTSAgent::isTerminal(const mjData* data) const {
+    return std::abs(data->qpos[0]) > config_.x_threshold;
+}
+
+uint64_t MCTSAgent::hashState(const double* state) const {
+    uint64_t h = 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < state_size_; ++i) {
+        int64_t cell = std::llround(state[i] / quantum_[i]);
+        h = mix(h ^ static_cast<uint64_t>(cell));
+    }
+    return h;
+}
+
+MCTSAgent::Stats* MCTSAgent::lookup(const double* state) {
+    table_lookups_.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t hash = hashState(state);
+    const uint64_t tag = (hash & ~kGenerationMask) | generation_;
+    const uint64_t mask = static_cast<uint64_t>(config_.table_size) - 1;
+
+    for (int probe = 0; probe < kMaxProbes; ++probe) {
+        TableEntry& entry = table_[(hash + probe) & mask];
+        uint64_t seen = entry.tag.load(std::memory_order_acquire);
+        while (true) {
+            if (seen == tag) {
+                table_hits_.fetch_add(1, std::memory_order_relaxed);
+                return &entry.stats;
+            }
+            if (seen == kClaiming) {
+                // Another thread is resetting this slot; it is published in a few stores
+                std::this_thread::yield();
+                seen = entry.tag.load(std::memory_order_acquire);
+                continue;
+            }
+            if ((seen & kGenerationMask) == generation_) {
+                break;  // Live entry for a different state: next slot
+            }
+            // Stale or empty: claim it, reset the statistics, then publish the tag
+            if (entry.tag.compare_exchange_weak(seen, kClaiming, std::memory_order_acquire)) {
+                entry.stats.visits.store(0, std::memory_order_relaxed);
+                entry.stats.value_sum.store(0.0, std::memory_order_relaxed);
+                entry.tag.store(tag, std::memory_order_release);
+                return &entry.stats;
+            }
+        }
+    }
+    return nullptr;  // Neighbourhood full: the node keeps private statistics
+}
+
+std::vector<std::pair<std::string, double>> MCTSAgent::getStats() const {
+    int64_t lookups = table_lookups_.load();
+    return {
+        {"nodes", static_cast<double>(last_nodes_)},
+        {"root_value", last_root_value_},
+        {"threads", static_cast<double>(num_threads_)},
+        {"transposition_hit_rate", lookups > 0 ? static_cast<double>(table_hits_.load()) / lookups : 0.0}
+    };
+}
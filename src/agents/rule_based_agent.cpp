@@ -38,6 +38,10 @@ void RuleBasedAgent::learn(const Experience& experience) {
     // The rules are fixed and don't change based on experience
 }
 
+std::unique_ptr<Agent> RuleBasedAgent::clone() const {
+    return std::make_unique<RuleBasedAgent>(*this);
+}
+
 std::vector<std::pair<std::string, double>> RuleBasedAgent::getStats() const {
     return {
         {"total_actions", static_cast<double>(total_actions_)},
@@ -0,0 +1,311 @@
+#include "../include/tile_coding_agent.h"
+#include "../include/checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+TileCoder::TileCoder(const Config& config)
+    : config_(config), num_features_(0) {
+    if (config_.num_tilings <= 0 || config_.tiles_per_dim <= 0) {
+        throw std::invalid_argument("TileCoder needs positive tilings and tiles per dimension");
+    }
+
+    // One extra tile per dimension absorbs the tiling offset
+    int cells = config_.tiles_per_dim + 1;
+    int tiles_per_tiling = 1;
+    for (int d = kStateDim - 1; d >= 0; --d) {
+        inv_width_[d] = config_.tiles_per_dim / (config_.high[d] - config_.low[d]);
+        stride_[d] = tiles_per_tiling;
+        tiles_per_tiling *= cells;
+    }
+
+    // Asymmetric offsets (1, 3, 5, 7) / num_tilings avoid diagonal artifacts
+    offsets_.resize(kStateDim * config_.num_tilings);
+    tiling_base_.resize(config_.num_tilings);
+    for (int t = 0; t < config_.num_tilings; ++t) {
+        for (int d = 0; d < kStateDim; ++d) {
+            double offset = static_cast<double>(t * (2 * d + 1)) / config_.num_tilings;
+            offsets_[d * config_.num_tilings + t] = offset - std::floor(offset);
+        }
+        tiling_base_[t] = t * tiles_per_tiling;
+    }
+    num_features_ = config_.num_tilings * tiles_per_tiling;
+}
+
+void TileCoder::features(const State& state, int* out) const {
+    const int n = config_.num_tilings;
+    const double max_cell = static_cast<double>(config_.tiles_per_dim);
+
+    for (int t = 0; t < n; ++t) {
+        out[t] = tiling_base_[t];
+    }
+
+    for (int d = 0; d < kStateDim; ++d) {
+        double value = state[d];
+        if (d == config_.angle_dim) {
+            // Wrap the unbounded pole angle into [low, high)
+            double span = config_.high[d] - config_.low[d];
+            value -= span * std::floor((value - config_.low[d]) / span);
+        }
+        const double scaled = (value - config_.low[d]) * inv_width_[d];
+        const double* offsets = &offsets_[d * n];
+        const int stride = stride_[d];
+
+        // Clamp with min/max and truncate: no branches, vectorizes over tilings
+        for (int t = 0; t < n; ++t) {
+            double coord = std::min(std::max(scaled + offsets[t], 0.0), max_cell);
+            out[t] += static_cast<int>(coord) * stride;
+        }
+    }
+}
+
+TileCodingAgent::TileCodingAgent() : TileCodingAgent(Config()) {
+}
+
+TileCodingAgent::TileCodingAgent(const Config& config)
+    : config_(config), coder_(config.tiles), num_actions_(config.num_actions),
+      weight_view_(nullptr), pending_action_(-1), rng_(config.seed), uniform_dist_(0.0, 1.0),
+      epsilon_(config.epsilon), total_updates_(0), last_td_error_(0.0), updates_total_(nullptr) {
+    if (num_actions_ < 2) {
+        throw std::invalid_argument("TileCodingAgent needs at least two actions");
+    }
+
+    // Evenly spaced forces; two actions give the bang-bang set {-max, +max}
+    actions_.resize(num_actions_);
+    for (int a = 0; a < num_actions_; ++a) {
+        actions_[a] = -config_.max_force + 2.0 * config_.max_force * a / (num_actions_ - 1);
+    }
+
+    weights_.assign(static_cast<size_t>(coder_.numFeatures()) * num_actions_, 0.0f);
+    weight_view_ = weights_.data();
+    trace_slot_.assign(weights_.size(), -1);
+    features_.resize(coder_.numTilings());
+    next_features_.resize(coder_.numTilings());
+    q_values_.resize(num_actions_);
+
+    if (config_.telemetry) {
+        updates_total_ = &Telemetry::global().counter("cartpole_learner_updates_total",
+                                                      "Parameter updates applied");
+    }
+}
+
+Action TileCodingAgent::act(const State& state) {
+    if (state.size() < static_cast<size_t>(TileCoder::kStateDim)) {
+        return 0.0;
+    }
+
+    // Reuse the action already committed to while bootstrapping (SARSA), but only
+    // if this is the state it was chosen for: its features are what learn() coded
+    coder_.features(state, features_.data());
+    if (training_mode_ && pending_action_ >= 0) {
+        int action = pending_action_;
+        pending_action_ = -1;
+        if (std::equal(features_.begin(), features_.end(), next_features_.begin())) {
+            return actions_[action];
+        }
+    }
+
+    actionValues(features_.data(), q_values_.data());
+    int action = training_mode_ ? selectAction(q_values_.data()) : greedyAction(q_values_.data());
+    return actions_[action];
+}
+
+void TileCodingAgent::learn(const Experience& experience) {
+    if (!training_mode_) {
+        return;
+    }
+
+    const int action = actionIndex(experience.action);
+    coder_.features(experience.state, features_.data());
+    actionValues(features_.data(), q_values_.data());
+    const double q_sa = q_values_[action];
+
+    // Replacing traces for the features active in (s, a)
+    for (int t = 0; t < coder_.numTilings(); ++t) {
+        setTrace(features_[t] * num_actions_ + action);
+    }
+
+    double target = experience.reward;
+    bool cut_traces = experience.done;
+    pending_action_ = -1;
+
+    if (!experience.done) {
+        coder_.features(experience.next_state, next_features_.data());
+        actionValues(next_features_.data(), q_values_.data());
+
+        int behavior = selectAction(q_values_.data());
+        int bootstrap = behavior;
+        if (config_.algorithm == Algorithm::QLearning) {
+            bootstrap = greedyAction(q_values_.data());
+            // Watkins: traces are only valid while following the greedy policy
+            cut_traces = q_values_[behavior] < q_values_[bootstrap];
+        }
+        target += config_.gamma * q_values_[bootstrap];
+
+        pending_action_ = behavior;
+    }
+
+    const double td_error = target - q_sa;
+    const float step = static_cast<float>(config_.alpha / coder_.numTilings() * td_error);
+    float* weights = weights_.data();
+    for (const Trace& trace : traces_) {
+        weights[trace.weight] += step * trace.value;
+    }
+
+    if (cut_traces) {
+        clearTraces();
+    } else {
+        decayTraces(config_.gamma * config_.lambda);
+    }
+
+    last_td_error_ = td_error;
+    total_updates_++;
+    if (updates_total_) {
+        updates_total_->add();
+    }
+}
+
+void TileCodingAgent::reset() {
+    clearTraces();
+    pending_action_ = -1;
+    epsilon_ = std::max(config_.min_epsilon, epsilon_ * config_.epsilon_decay);
+}
+
+void TileCodingAgent::setTrainingMode(bool training) {
+    // Leaving frozen mode: copy mapped weights into owned, writable storage
+    if (training && mapped_) {
+        std::copy(weight_view_, weight_view_ + weights_.size(), weights_.begin());
+        weight_view_ = weights_.data();
+        mapped_.reset();
+    }
+    training_mode_ = training;
+    pending_action_ = -1;
+}
+
+std::unique_ptr<Agent> TileCodingAgent::clone() const {
+    auto copy = std::make_unique<TileCodingAgent>(*this);
+    // Owned weights were copied; a mapped view is shared
+    if (!mapped_) {
+        copy->weight_view_ = copy->weights_.data();
+    }
+    return copy;
+}
+
+void TileCodingAgent::saveState(CheckpointWriter& writer) const {
+    const int32_t shape[] = {coder_.numFeatures(), num_actions_, coder_.numTilings(),
+                             config_.tiles.tiles_per_dim};
+    std::ostringstream rng_state;
+    rng_state << rng_;
+
+    writer.setStep(static_cast<uint64_t>(total_updates_));
+    writer.addCopy("shape", shape, 4);
+    writer.add("weights", weight_view_, weights_.size());
+    writer.add("optimizer/epsilon", &epsilon_, 1);
+    writer.add("optimizer/total_updates", &total_updates_, 1);
+    writer.addString("rng", rng_state.str());
+}
+
+void TileCodingAgent::loadState(const std::shared_ptr<const MappedCheckpoint>& checkpoint) {
+    BlobView<int32_t> shape = checkpoint->view<int32_t>("shape");
+    BlobView<float> weights = checkpoint->view<float>("weights");
+    BlobView<double> epsilon = checkpoint->view<double>("optimizer/epsilon");
+    BlobView<int64_t> total_updates = checkpoint->view<int64_t>("optimizer/total_updates");
+    if (shape.size != 4 || shape[0] != coder_.numFeatures() || shape[1] != num_actions_ ||
+        shape[2] != coder_.numTilings() || weights.size != weights_.size() ||
+        epsilon.size != 1 || total_updates.size != 1) {
+        throw std::runtime_error("Checkpoint does not match TileCodingAgent configuration");
+    }
+
+    // Frozen agents read weights in place from the mapping; learners take a copy
+    if (training_mode_) {
+        std::copy(weights.begin(), weights.end(), weights_.begin());
+        weight_view_ = weights_.data();
+        mapped_.reset();
+    } else {
+        weight_view_ = weights.data;
+        mapped_ = checkpoint;
+    }
+
+    epsilon_ = epsilon[0];
+    total_updates_ = total_updates[0];
+    std::istringstream rng_state(checkpoint->string("rng"));
+    rng_state >> rng_;
+
+    clearTraces();
+    pending_action_ = -1;
+}
+
+std::vector<std::pair<std::string, double>> TileCodingAgent::getStats() const {
+    return {
+        {"total_updates", static_cast<double>(total_updates_)},
+        {"epsilon", epsilon_},
+        {"last_td_error", last_td_error_},
+        {"active_traces", static_cast<double>(traces_.size())},
+        {"num_weights", static_cast<double>(weights_.size())}
+    };
+}
+
+void TileCodingAgent::actionValues(const int* features, double* q) const {
+    std::fill(q, q + num_actions_, 0.0);
+    const float* weights = weight_view_;
+    for (int t = 0; t < coder_.numTilings(); ++t) {
+        const float* row = weights + static_cast<size_t>(features[t]) * num_actions_;
+        for (int a = 0; a < num_actions_; ++a) {
+            q[a] += row[a];
+        }
+    }
+}
+
+int TileCodingAgent::greedyAction(const double* q) const {
+    return static_cast<int>(std::max_element(q, q + num_actions_) - q);
+}
+
+int TileCodingAgent::selectAction(const double* q) {
+    if (uniform_dist_(rng_) < epsilon_) {
+        return std::uniform_int_distribution<int>(0, num_actions_ - 1)(rng_);
+    }
+    return greedyAction(q);
+}
+
+int TileCodingAgent::actionIndex(Action action) const {
+    double scaled = (action + config_.max_force) / (2.0 * config_.max_force) * (num_actions_ - 1);
+    int index = static_cast<int>(std::lround(scaled));
+    return std::max(0, std::min(num_actions_ - 1, index));
+}
+
+void TileCodingAgent::setTrace(int32_t weight) {
+    int32_t slot = trace_slot_[weight];
+    if (slot >= 0) {
+        traces_[slot].value = 1.0f;
+        return;
+    }
+    trace_slot_[weight] = static_cast<int32_t>(traces_.size());
+    traces_.push_back({weight, 1.0f});
+}
+
+void TileCodingAgent::decayTraces(double factor) {
+    const float decay = static_cast<float>(factor);
+    const float min_trace = static_cast<float>(config_.min_trace);
+
+    // Decay in place and compact away traces that fell below the threshold
+    size_t kept = 0;
+    for (size_t i = 0; i < traces_.size(); ++i) {
+        Trace trace = traces_[i];
+        trace.value *= decay;
+        if (trace.value >= min_trace) {
+            trace_slot_[trace.weight] = static_cast<int32_t>(kept);
+            traces_[kept++] = trace;
+        } else {
+            trace_slot_[trace.weight] = -1;
+        }
+    }
+    traces_.resize(kept);
+}
+
+void TileCodingAgent::clearTraces() {
+    for (const Trace& trace : traces_) {
+        trace_slot_[trace.weight] = -1;
+    }
+    traces_.clear();
+}
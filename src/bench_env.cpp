@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cartpole_dynamics.h"
+#include "cartpole_env.h"
+#include "cartpole_env_t.h"
+#include "cartpole_model.h"
+#include "es_agent.h"
+#include "es_trainer.h"
+#include "inference_broker.h"
+#include "mcts_agent.h"
+#include "rule_based_agent.h"
+#include "telemetry.h"
+#include "tile_coding_agent.h"
+#include "vector_env.h"
+
+// Step-rate benchmark: virtual Environment/Agent loop vs. static CartPoleEnvT loop
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string& name, long long steps, double seconds) {
+    std::cout << std::left << std::setw(28) << name
+              << std::right << std::setw(14) << std::fixed << std::setprecision(0)
+              << steps / seconds << " steps/s" << std::endl;
+}
+
+// Fully static loop for a model with nq + nv == ObsDim; returns the steps taken
+template <int ObsDim>
+long long runStatic(const mjModel* model, long long total_steps, int max_steps, double& seconds) {
+    CartPoleEnvT<UprightReward, CartBoundsTermination, ObsDim> env(model, max_steps);
+    env.seed(0);
+    BangBangPolicy policy{10.0};
+    auto start = std::chrono::steady_clock::now();
+    long long steps = 0;
+    while (steps < total_steps) {
+        steps += runEpisodeT(env, policy, max_steps).steps;
+    }
+    seconds = secondsSince(start);
+    return steps;
+}
+
+// The observation size of CartPoleEnvT is a template argument, so links are dispatched here
+long long runStaticForLinks(int links, const mjModel* model, long long total_steps,
+                            int max_steps, double& seconds) {
+    switch (links) {
+    case 1: return runStatic<4>(model, total_steps, max_steps, seconds);
+    case 2: return runStatic<6>(model, total_steps, max_steps, seconds);
+    case 3: return runStatic<8>(model, total_steps, max_steps, seconds);
+    case 4: return runStatic<10>(model, total_steps, max_steps, seconds);
+    case 5: return runStatic<12>(model, total_steps, max_steps, seconds);
+    case 6: return runStatic<14>(model, total_steps, max_steps, seconds);
+    case 7: return runStatic<16>(model, total_steps, max_steps, seconds);
+    case 8: return runStatic<18>(model, total_steps, max_steps, seconds);
+    default: return 0;
+    }
+}
+
+// Each thread steps its own environment with its own clone of the agent
+double runThreads(const mjModel* model, const Agent& agent, int threads, long long steps_per_thread) {
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            CartPoleEnv env(model);
+            std::unique_ptr<Agent> local = agent.clone();
+            State state = env.reset();
+            for (long long i = 0; i < steps_per_thread; ++i) {
+                auto [next_state, reward, done, info] = env.step(local->act(state));
+                state = done ? env.reset() : next_state;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return secondsSince(start);
+}
+
+// Return of the linear policy u = w . [x, x_dot, theta, theta_dot] + w[4] through mj_step
+double mujocoPolicyReturn(const mjModel* model, mjData* data, const double weights[5],
+                          const double initial[4], int steps) {
+    mj_resetData(model, data);
+    data->qpos[0] = initial[0];
+    data->qvel[0] = initial[1];
+    data->qpos[1] = initial[2];
+    data->qvel[1] = initial[3];
+    double total = 0.0;
+    for (int t = 0; t < steps; ++t) {
+        data->ctrl[0] = weights[4] + weights[0] * data->qpos[0] + weights[1] * data->qvel[0] +
+                        weights[2] * data->qpos[1] + weights[3] * data->qvel[1];
+        mj_step(model, data);
+        total += std::cos(data->qpos[1]) + 1.0;
+    }
+    return total;
+}
+
+// Analytic dynamics against MuJoCo, then gradient cost against central differences
+void benchGradient(const mjModel* model, int steps) {
+    CartPoleDynamics dynamics(model);
+    mjData* data = mj_makeData(model);
+    const double weights[5] = {0.5, 0.3, -2.0, -0.4, 0.1};
+    const double initial[4] = {0.0, 0.0, dynamics.parameters().qpos0[1] + 0.3, 0.0};
+
+    // Same open-loop forces through both simulators
+    mj_resetData(model, data);
+    data->qpos[1] = initial[2];
+    double state[4] = {initial[0], initial[1], initial[2], initial[3]};
+    double next[4];
+    double max_error = 0.0;
+    for (int t = 0; t < steps; ++t) {
+        const double force = 5.0 * std::sin(0.05 * t);
+        data->ctrl[0] = force;
+        mj_step(model, data);
+        dynamics.step(state, force, next);
+        std::copy(next, next + 4, state);
+        const double mujoco_state[4] = {data->qpos[0], data->qvel[0], data->qpos[1], data->qvel[1]};
+        for (int i = 0; i < 4; ++i) {
+            max_error = std::max(max_error, std::abs(mujoco_state[i] - state[i]));
+        }
+    }
+    std::cout << "Analytic vs. mj_step over " << steps << " steps: max state error "
+              << std::scientific << std::setprecision(2) << max_error << std::fixed << std::endl;
+
+    const int repeats = 20;
+    double gradient[5];
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        dynamics.linearPolicyReturn(weights, initial, steps, gradient);
+    }
+    const double analytic_seconds = secondsSince(start) / repeats;
+
+    start = std::chrono::steady_clock::now();
+    double fd_gradient[5];
+    for (int r = 0; r < repeats; ++r) {
+        for (int i = 0; i < 5; ++i) {
+            double plus[5];
+            double minus[5];
+            std::copy(weights, weights + 5, plus);
+            std::copy(weights, weights + 5, minus);
+            plus[i] += 1e-6;
+            minus[i] -= 1e-6;
+            fd_gradient[i] = (mujocoPolicyReturn(model, data, plus, initial, steps) -
+                              mujocoPolicyReturn(model, data, minus, initial, steps)) / 2e-6;
+        }
+    }
+    const double fd_seconds = secondsSince(start) / repeats;
+    mj_deleteData(data);
+
+    std::cout << "Policy gradient, " << steps << "-step episode:" << std::endl
+              << "  dual numbers        " << std::setprecision(1) << analytic_seconds * 1e6 << " us" << std::endl
+              << "  finite differences  " << fd_seconds * 1e6 << " us (10 mj_step rollouts)" << std::endl
+              << "  dR/dw dual [" << std::setprecision(3);
+    for (int i = 0; i < 5; ++i) {
+        std::cout << (i ? ", " : "") << gradient[i];
+    }
+    std::cout << "]" << std::endl << "  dR/dw fd   [";
+    for (int i = 0; i < 5; ++i) {
+        std::cout << (i ? ", " : "") << fd_gradient[i];
+    }
+    std::cout << "]" << std::endl;
+}
+
+// Auto-resetting batch with short episodes, resetting inline or on the reset thread
+double runVector(const mjModel* model, int num_envs, int episode_steps, bool background,
+                 long long total_steps, long long& episodes) {
+    VectorCartPoleEnv::Config config;
+    config.num_envs = num_envs;
+    config.background_reset = background;
+    VectorCartPoleEnv envs(model, config);
+    for (int i = 0; i < envs.size(); ++i) {
+        envs.env(i).setMaxEpisodeSteps(episode_steps);
+    }
+
+    std::vector<Action> actions(num_envs);
+    envs.reset();
+    auto start = std::chrono::steady_clock::now();
+    for (long long steps = 0; steps < total_steps; steps += num_envs) {
+        // Row by row, so a background reset only holds up its own environment
+        for (int i = 0; i < num_envs; ++i) {
+            actions[i] = envs.observation(i)[1] > 0.0 ? -10.0 : 10.0;
+        }
+        envs.step(actions.data());
+    }
+    episodes = envs.episodesCompleted();
+    return secondsSince(start);
+}
+
+// TileCodingAgent on transitions collected up front, so only the agent is timed
+void benchTileCoding(const mjModel* model, long long updates) {
+    CartPoleEnv env(model);
+    env.seed(0);
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> force(-10.0, 10.0);
+    std::vector<Experience> transitions;
+    transitions.reserve(100000);
+    State state = env.reset();
+    while (transitions.size() < transitions.capacity()) {
+        Action action = force(rng);
+        auto [next_state, reward, done, info] = env.step(action);
+        transitions.emplace_back(state, action, reward, next_state, done);
+        state = done ? env.reset() : next_state;
+    }
+
+    TileCodingAgent agent;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < updates; ++i) {
+        agent.learn(transitions[i % transitions.size()]);
+    }
+    report("TileCodingAgent learn()", updates, secondsSince(start));
+
+    // act() + learn() as in training: act() reuses the action picked while bootstrapping
+    start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < updates; ++i) {
+        const Experience& transition = transitions[i % transitions.size()];
+        agent.act(transition.state);
+        agent.learn(transition);
+    }
+    report("TileCodingAgent act+learn", updates, secondsSince(start));
+}
+
+// MCTS acting in CartPoleEnv with 1, 2, 4, ... max_threads search threads
+void benchMcts(std::shared_ptr<const mjModel> model, int max_threads, int simulations, int steps) {
+    std::cout << "MCTS, " << simulations << " simulations per action, " << steps << " steps:" << std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        MCTSAgent::Config config;
+        config.num_threads = threads;
+        config.num_simulations = simulations;
+        MCTSAgent agent(model, config);
+        CartPoleEnv env(model.get());
+        env.seed(0);
+
+        long long nodes = 0;
+        double hits = 0.0;
+        double total_reward = 0.0;
+        int taken = 0;
+        auto start = std::chrono::steady_clock::now();
+        State state = env.reset();
+        for (; taken < steps; ++taken) {
+            auto [next_state, reward, done, info] = env.step(agent.act(state));
+            for (const auto& [name, value] : agent.getStats()) {
+                if (name == "nodes") {
+                    nodes += static_cast<long long>(value);
+                } else if (name == "transposition_hit_rate") {
+                    hits += value;
+                }
+            }
+            total_reward += reward;
+            if (done) {
+                ++taken;
+                break;
+            }
+            state = std::move(next_state);
+        }
+        const double seconds = secondsSince(start);
+        std::cout << "  threads " << std::setw(3) << threads
+                  << "  nodes/s " << std::setw(10) << std::fixed << std::setprecision(0) << nodes / seconds
+                  << "  hit rate " << std::setprecision(3) << hits / taken
+                  << "  return " << std::setprecision(1) << total_reward << " in " << taken << " steps"
+                  << std::endl;
+    }
+}
+
+// Trains an ESAgent for a number of generations and saves it, e.g. for rollout_coordinator --policy
+void trainEs(const mjModel* model, int links, int generations, const std::string& path) {
+    ESAgent::Config config;
+    config.observation_size = model->nq + model->nv;
+    config.angle_index = links == 1 ? 2 : -1;
+    ESAgent agent(config);
+
+    auto noise = std::make_shared<const NoiseTable>(1 << 24, 42);
+    ESTrainer trainer([model] { return std::make_unique<CartPoleEnv>(model); }, noise,
+                      ESTrainer::Config());
+    long long steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int g = 0; g < generations; ++g) {
+        ESTrainer::Generation generation = trainer.step(agent);
+        ESTrainer::printGeneration(generation);
+        steps += generation.steps;
+    }
+    report("ES training", steps, secondsSince(start));
+    agent.saveModel(path);
+    std::cout << "Saved " << path << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    // bench_env [steps] [--links N] [--broker THREADS [--max-batch B] [--delay-us D]] [--gradient]
+    //           [--vector ENVS [--episode-steps K]] [--mcts MAX_THREADS [--simulations N]]
+    //           [--es GENERATIONS [--save PATH]] [--tile-coding]
+    //           [--telemetry-port PORT] [--telemetry-file PATH]
+    long long total_steps = 1000000;
+    int links = 0;
+    int vector_envs = 0;
+    int episode_steps = 50;
+    bool gradient = false;
+    bool tile_coding = false;
+    int broker_threads = 0;
+    int mcts_threads = 0;
+    int mcts_simulations = 2000;
+    int es_generations = 0;
+    std::string es_path = "es.ckpt";
+    TelemetryExporter::Config telemetry_config;
+    InferenceBroker::Config broker_config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--links" && i + 1 < argc) {
+            links = std::stoi(argv[++i]);
+        } else if (arg == "--broker" && i + 1 < argc) {
+            broker_threads = std::stoi(argv[++i]);
+        } else if (arg == "--max-batch" && i + 1 < argc) {
+            broker_config.max_batch = std::stoi(argv[++i]);
+        } else if (arg == "--delay-us" && i + 1 < argc) {
+            broker_config.max_delay_us = std::stoi(argv[++i]);
+        } else if (arg == "--gradient") {
+            gradient = true;
+        } else if (arg == "--tile-coding") {
+            tile_coding = true;
+        } else if (arg == "--vector" && i + 1 < argc) {
+            vector_envs = std::stoi(argv[++i]);
+        } else if (arg == "--episode-steps" && i + 1 < argc) {
+            episode_steps = std::stoi(argv[++i]);
+        } else if (arg == "--mcts" && i + 1 < argc) {
+            mcts_threads = std::stoi(argv[++i]);
+        } else if (arg == "--simulations" && i + 1 < argc) {
+            mcts_simulations = std::stoi(argv[++i]);
+        } else if (arg == "--es" && i + 1 < argc) {
+            es_generations = std::stoi(argv[++i]);
+        } else if (arg == "--save" && i + 1 < argc) {
+            es_path = argv[++i];
+        } else if (arg == "--telemetry-port" && i + 1 < argc) {
+            telemetry_config.http_port = std::stoi(argv[++i]);
+        } else if (arg == "--telemetry-file" && i + 1 < argc) {
+            telemetry_config.file_path = argv[++i];
+        } else {
+            total_steps = std::stoll(arg);
+        }
+    }
+    const int max_steps = 500;
+
+    try {
+        // Live metrics (steps, episodes and updates per second, broker queues) while modes run
+        std::unique_ptr<TelemetryExporter> exporter;
+        if (telemetry_config.http_port != 0 || !telemetry_config.file_path.empty()) {
+            exporter = std::make_unique<TelemetryExporter>(Telemetry::global(), telemetry_config);
+            if (exporter->httpPort() > 0) {
+                std::cout << "Telemetry: http://127.0.0.1:" << exporter->httpPort() << "/metrics" << std::endl;
+            }
+        }
+
+        // --links uses a generated model; otherwise the single pole from disk
+        std::shared_ptr<const mjModel> base_model;
+        if (links > 0) {
+            CartPoleModelSpec spec;
+            spec.num_links = links;
+            base_model = buildCartPoleModel(spec);
+        } else {
+            base_model = CartPoleEnv::loadModel("mujoco/cartpole.xml");
+            links = 1;
+        }
+        std::cout << "Links: " << links << ", state size: "
+                  << base_model->nq + base_model->nv << std::endl;
+
+        // Virtual dispatch on every act/step, vector states. Same work per step as the
+        // static loop below: act, step, reset on done (no learn or Experience copies)
+        double virtual_rate;
+        {
+            std::unique_ptr<Environment> env = std::make_unique<CartPoleEnv>(base_model.get());
+            env->seed(0);
+            std::unique_ptr<Agent> agent = std::make_unique<RuleBasedAgent>(10.0);
+            auto start = std::chrono::steady_clock::now();
+            State state = env->reset();
+            for (long long i = 0; i < total_steps; ++i) {
+                auto [next_state, reward, done, info] = env->step(agent->act(state));
+                state = done ? env->reset() : next_state;
+            }
+            double seconds = secondsSince(start);
+            virtual_rate = total_steps / seconds;
+            report("Environment/Agent (virtual)", total_steps, seconds);
+        }
+
+        // Same loop through the adapter (virtual interface over the template)
+        if (links == 1) {
+            std::unique_ptr<Environment> env =
+                std::make_unique<EnvironmentAdapter<FastCartPoleEnv>>(base_model.get());
+            env->seed(0);
+            RuleBasedAgent agent(10.0);
+            auto start = std::chrono::steady_clock::now();
+            State state = env->reset();
+            for (long long i = 0; i < total_steps; ++i) {
+                auto [next_state, reward, done, info] = env->step(agent.act(state));
+                state = done ? env->reset() : next_state;
+            }
+            report("EnvironmentAdapter", total_steps, secondsSince(start));
+        }
+
+        // Fully static: inlined reward/termination, std::array observations
+        // Whole episodes, so it may run a few more steps than total_steps: compare rates
+        double seconds = 0.0;
+        long long steps = runStaticForLinks(links, base_model.get(), total_steps, max_steps, seconds);
+        if (steps > 0) {
+            double static_rate = steps / seconds;
+            report("CartPoleEnvT (static)", steps, seconds);
+            std::cout << "Speedup over virtual loop: " << std::setprecision(2)
+                      << static_rate / virtual_rate << "x" << std::endl;
+        } else {
+            std::cout << "CartPoleEnvT (static) is instantiated for 1-8 links only" << std::endl;
+        }
+
+        if (gradient) {
+            if (links == 1) {
+                benchGradient(base_model.get(), max_steps);
+            } else {
+                std::cout << "CartPoleDynamics models the single pole only" << std::endl;
+            }
+        }
+
+        if (vector_envs > 0) {
+            for (bool background : {false, true}) {
+                long long episodes = 0;
+                double vector_seconds = runVector(base_model.get(), vector_envs, episode_steps,
+                                                  background, total_steps, episodes);
+                report(std::string(background ? "Vector, background reset" : "Vector, inline reset"),
+                       total_steps, vector_seconds);
+                std::cout << "  " << episodes << " episodes of <= " << episode_steps << " steps" << std::endl;
+            }
+        }
+
+        if (tile_coding) {
+            benchTileCoding(base_model.get(), total_steps);
+        }
+
+        if (es_generations > 0) {
+            trainEs(base_model.get(), links, es_generations, es_path);
+        }
+
+        if (mcts_threads > 0) {
+            benchMcts(base_model, mcts_threads, mcts_simulations, 200);
+        }
+
+        // Many environment threads: per-thread MLP copies vs. one batched MLP
+        if (broker_threads > 0) {
+            ESAgent::Config es_config;
+            es_config.observation_size = base_model->nq + base_model->nv;
+            es_config.angle_index = -1;
+            const long long per_thread = total_steps / broker_threads;
+            const long long steps_run = per_thread * broker_threads;
+
+            ESAgent direct(es_config);
+            report("Per-thread ESAgent x" + std::to_string(broker_threads), steps_run,
+                   runThreads(base_model.get(), direct, broker_threads, per_thread));
+
+            auto broker = std::make_shared<InferenceBroker>(std::make_shared<ESAgent>(es_config),
+                                                            broker_config);
+            BrokeredAgent brokered(broker);
+            report("InferenceBroker x" + std::to_string(broker_threads), steps_run,
+                   runThreads(base_model.get(), brokered, broker_threads, per_thread));
+            std::cout << "  max batch " << broker_config.max_batch
+                      << ", deadline " << broker_config.max_delay_us << " us: mean batch "
+                      << std::setprecision(1) << broker->meanBatchSize()
+                      << ", latency p50 " << broker->latency().quantileMicros(0.5)
+                      << " us, p99 " << broker->latency().quantileMicros(0.99) << " us" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "cartpole_dynamics.h"
+#include <stdexcept>
+
+CartPoleDynamics::CartPoleDynamics(const mjModel* model) : p_(parametersFromModel(model)) {
+}
+
+CartPoleParameters CartPoleDynamics::parametersFromModel(const mjModel* model) {
+    if (model->nq != 2 || model->nv != 2 || model->njnt != 2 || model->nu < 1 ||
+        model->jnt_type[0] != mjJNT_SLIDE || model->jnt_type[1] != mjJNT_HINGE) {
+        throw std::invalid_argument("CartPoleDynamics needs a slider and a single hinge");
+    }
+    // step() applies gear * ctrl as a force on the slider, so actuator 0 must drive it
+    if (model->actuator_trntype[0] != mjTRN_JOINT || model->actuator_trnid[0] != 0) {
+        throw std::invalid_argument("CartPoleDynamics needs actuator 0 to drive the slider joint");
+    }
+    if (model->opt.integrator != mjINT_EULER) {
+        throw std::invalid_argument("CartPoleDynamics reproduces the Euler integrator only");
+    }
+
+    const int cart = model->jnt_bodyid[0];
+    const int pole = model->jnt_bodyid[1];
+
+    CartPoleParameters p;
+    p.cart_mass = model->body_mass[cart];
+    p.pole_mass = model->body_mass[pole];
+    p.com_x = model->body_ipos[3 * pole + 0];
+    p.com_z = model->body_ipos[3 * pole + 2];
+
+    // Principal inertia rotated into the body frame; only the hinge (y) axis matters
+    const mjtNum* q = model->body_iquat + 4 * pole;
+    const double r[3] = {
+        2.0 * (q[1] * q[2] + q[0] * q[3]),
+        1.0 - 2.0 * (q[1] * q[1] + q[3] * q[3]),
+        2.0 * (q[2] * q[3] - q[0] * q[1])
+    };
+    const mjtNum* inertia = model->body_inertia + 3 * pole;
+    p.pole_inertia = r[0] * r[0] * inertia[0] + r[1] * r[1] * inertia[1] + r[2] * r[2] * inertia[2];
+
+    p.gravity = -model->opt.gravity[2];
+    p.timestep = model->opt.timestep;
+    p.gear = model->actuator_gear[0];
+    p.ctrl_min = model->actuator_ctrlrange[0];
+    p.ctrl_max = model->actuator_ctrlrange[1];
+    p.ctrl_limited = model->actuator_ctrllimited[0] != 0;
+    for (int j = 0; j < 2; ++j) {
+        p.damping[j] = model->dof_damping[model->jnt_dofadr[j]];
+        p.armature[j] = model->dof_armature[model->jnt_dofadr[j]];
+        p.qpos0[j] = model->qpos0[model->jnt_qposadr[j]];
+    }
+    return p;
+}
+
+void CartPoleDynamics::jacobians(const double state[4], double ctrl, double A[16], double B[4]) const {
+    using D = Dual<5>;
+    D x[4];
+    for (int i = 0; i < 4; ++i) {
+        x[i] = D::variable(state[i], i);
+    }
+    D next[4];
+    step(x, D::variable(ctrl, 4), next);
+
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            A[4 * i + j] = next[i].grad[j];
+        }
+        B[i] = next[i].grad[4];
+    }
+}
+
+double CartPoleDynamics::linearPolicyReturn(const double weights[5], const double initial[4],
+                                            int steps, double gradient[5]) const {
+    // Forward mode: the tangents are d(state)/d(weights), carried through every step
+    using D = Dual<5>;
+    D w[5];
+    for (int i = 0; i < 5; ++i) {
+        w[i] = D::variable(weights[i], i);
+    }
+    D state[4] = {initial[0], initial[1], initial[2], initial[3]};
+    D next[4];
+    D total;
+
+    for (int t = 0; t < steps; ++t) {
+        D u = w[4];
+        for (int i = 0; i < 4; ++i) {
+            u += w[i] * state[i];
+        }
+        step(state, u, next);
+        total += reward(next);
+        std::copy(next, next + 4, state);
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        gradient[i] = total.grad[i];
+    }
+    return total.value;
+}
+
+double CartPoleDynamics::linearPolicyReturn(const double weights[5], const double initial[4],
+                                            int steps) const {
+    double state[4] = {initial[0], initial[1], initial[2], initial[3]};
+    double next[4];
+    double total = 0.0;
+    for (int t = 0; t < steps; ++t) {
+        double u = weights[4];
+        for (int i = 0; i < 4; ++i) {
+            u += weights[i] * state[i];
+        }
+        step(state, u, next);
+        total += reward(next);
+        std::copy(next, next + 4, state);
+    }
+    return total;
+}
@@ -4,30 +4,60 @@
 #include <stdexcept>
 #include "GLFW/glfw3.h"
 
+namespace {
+
+mjModel* loadXMLOrThrow(const std::string& model_path) {
+    char error[1000] = "Could not load model";
+    mjModel* model = mj_loadXML(model_path.c_str(), nullptr, error, sizeof(error));
+    if (!model) {
+        throw std::runtime_error(std::string("Failed to load MuJoCo model: ") + error);
+    }
+    return model;
+}
+
+}  // namespace
+
 CartPoleEnv::CartPoleEnv(const std::string& model_path, bool render)
-    : model_(nullptr), data_(nullptr), cam_(nullptr), opt_(nullptr),
+    : CartPoleEnv(loadXMLOrThrow(model_path), render, AdoptModel{}) {
+}
+
+CartPoleEnv::CartPoleEnv(const mjModel* base_model, bool render)
+    : CartPoleEnv(mj_copyModel(nullptr, base_model), render, AdoptModel{}) {
+}
+
+CartPoleEnv::CartPoleEnv(mjModel* model, bool render, AdoptModel)
+    : model_(model), data_(nullptr), cam_(nullptr), opt_(nullptr),
       scn_(nullptr), con_(nullptr), window_(nullptr),
       max_force_(10.0), x_threshold_(2.4), theta_threshold_radians_(12 * M_PI / 180),
       max_episode_steps_(500), current_step_(0),
       rng_(std::random_device{}()), uniform_dist_(-0.05, 0.05),
-      render_enabled_(render) {
+      render_enabled_(render), custom_observation_(false),
+      state_memory_(std::pmr::get_default_resource()) {
     
-    // Load MuJoCo model
-    char error[1000] = "Could not load model";
-    model_ = mj_loadXML(model_path.c_str(), nullptr, error, sizeof(error));
     if (!model_) {
-        throw std::runtime_error(std::string("Failed to load MuJoCo model: ") + error);
+        throw std::runtime_error("Failed to copy MuJoCo model");
     }
     
     // Create data
     data_ = mj_makeData(model_);
     
+    // Joint state [x, x_dot, theta, theta_dot] unless a spec is set
+    observation_ = std::make_unique<ObservationPipeline>(ObservationSpec::jointState(model_), model_);
+    observation_buffer_.resize(observation_->size());
+    observation_->reset(data_, observation_buffer_.data());
+    
     // Initialize rendering if enabled
     if (render_enabled_) {
         initializeRendering();
     }
 }
 
+std::shared_ptr<const mjModel> CartPoleEnv::loadModel(const std::string& model_path) {
+    return std::shared_ptr<const mjModel>(loadXMLOrThrow(model_path), [](const mjModel* model) {
+        mj_deleteModel(const_cast<mjModel*>(model));
+    });
+}
+
 
 CartPoleEnv::~CartPoleEnv() {
     close();
@@ -102,15 +132,46 @@ void CartPoleEnv::cleanupRendering() {
 }
 
 State CartPoleEnv::reset() {
-    // Reset simulation data to XML defaults (pole hanging down due to ref="3.14159")
-    mj_resetData(model_, data_);
+    // Draw new physics before resetting so derived constants are consistent
+    if (randomizer_ && randomizer_->getMode() == DomainRandomizer::Mode::PerEpisode) {
+        setPhysicsVariant(randomizer_->sample(rng_));
+    }
     
-    // Forward dynamics to compute derived quantities
-    mj_forward(model_, data_);
+    // Write the start state directly instead of mj_resetData: the XML pose
+    // (pole hanging down due to ref="3.14159") plus uniform_dist_ noise, or a
+    // pooled state. Applied forces and mocap are never written by this class.
+    if (initial_states_) {
+        const double* start = initial_states_->sample(rng_);
+        mju_copy(data_->qpos, start, model_->nq);
+        mju_copy(data_->qvel, start + model_->nq, model_->nv);
+    } else {
+        for (int i = 0; i < model_->nq; ++i) {
+            data_->qpos[i] = model_->qpos0[i] + uniform_dist_(rng_);
+        }
+        for (int i = 0; i < model_->nv; ++i) {
+            data_->qvel[i] = uniform_dist_(rng_);
+        }
+    }
+    mju_zero(data_->ctrl, model_->nu);
+    mju_zero(data_->act, model_->na);
+    mju_zero(data_->qacc_warmstart, model_->nv);
+    data_->time = 0.0;
+    
+    // mj_step recomputes everything from qpos/qvel, so a forward pass is only
+    // needed when the observation or the viewer reads derived quantities now
+    if (observation_->needsForwardQuantities() || render_enabled_) {
+        mj_forward(model_, data_);
+    }
     
     // Reset step counter
     current_step_ = 0;
     
+    if (recorder_) {
+        recorder_->beginEpisode();
+        recorder_->record(data_);
+    }
+    
+    observation_->reset(data_, observation_buffer_.data());
     return getCurrentState();
 }
 
@@ -122,30 +183,56 @@ StepResult CartPoleEnv::step(Action action) {
     data_->ctrl[0] = action;
     
     // Step simulation
-    mj_step(model_, data_);
+    advance();
+    
+    if (recorder_) {
+        recorder_->record(data_);
+    }
     
     // Get new state
+    observation_->push(data_, observation_buffer_.data());
     State state = getCurrentState();
     
     // Check if done
     bool done = isDone() || (++current_step_ >= max_episode_steps_);
     
     // Compute reward
-    double reward = computeReward(state, done);
+    double reward = computeReward(done);
     
     // Info string
     std::string info = done ? (current_step_ >= max_episode_steps_ ? "TimeLimit" : "Terminated") : "";
     
-    return std::make_tuple(state, reward, done, info);
+    return std::make_tuple(std::move(state), reward, done, std::move(info));
+}
+
+void CartPoleEnv::advance() {
+    if (!observation_->needsForwardQuantities()) {
+        mj_step(model_, data_);
+    } else if (model_->opt.integrator == mjINT_RK4) {
+        mj_step(model_, data_);
+        mj_forward(model_, data_);
+    } else {
+        // Finish the step begun by the previous mj_step1/mj_forward, then
+        // recompute sensors and energy for the new state at no extra cost
+        mj_step2(model_, data_);
+        mj_step1(model_, data_);
+    }
 }
 
 State CartPoleEnv::getCurrentState() const {
-    return {
-        data_->qpos[0],  // cart position
-        data_->qvel[0],  // cart velocity
-        data_->qpos[1],  // pole angle
-        data_->qvel[1]   // pole angular velocity
-    };
+    return State(observation_buffer_.begin(), observation_buffer_.end(), state_memory_);
+}
+
+void CartPoleEnv::setObservationSpec(const ObservationSpec& spec) {
+    observation_ = std::make_unique<ObservationPipeline>(spec, model_);
+    observation_buffer_.assign(observation_->size(), 0.0);
+    // Sensors and energy must describe the current state, and advance() finishes
+    // with mj_step2, which relies on a forward pass for that state
+    if (observation_->needsForwardQuantities()) {
+        mj_forward(model_, data_);
+    }
+    observation_->reset(data_, observation_buffer_.data());
+    custom_observation_ = true;
 }
 
 bool CartPoleEnv::isDone() const {
@@ -157,12 +244,17 @@ bool CartPoleEnv::isDone() const {
     return (x < -x_threshold_ || x > x_threshold_);
 }
 
-double CartPoleEnv::computeReward(const std::vector<double>& state, bool done) const {
-    double theta = state[2];  // pole angle
-    
-    // Reward based on how close pole is to upright (θ = 0 or θ = 2π)
-    // cos(θ) = 1 when upright, -1 when hanging down
-    double upright_reward = cos(theta);  // Range: [-1, 1]
+double CartPoleEnv::computeReward(bool done) const {
+    // Reward based on how close each link is to upright (θ = 0 or θ = 2π)
+    // cos(θ) = 1 when upright, -1 when hanging down. Hinges after the first
+    // are relative to their parent link, so absolute angles accumulate.
+    double theta = 0.0;
+    double upright_reward = 0.0;
+    for (int j = 1; j < model_->nq; ++j) {
+        theta += data_->qpos[j];
+        upright_reward += cos(theta);
+    }
+    upright_reward /= getNumLinks();  // Range: [-1, 1]
     
     // Scale to [0, 2] so upright gives +2, hanging gives 0
     return upright_reward + 1.0;
@@ -195,7 +287,7 @@ void CartPoleEnv::render() {
              "Step: %d\nCart Pos: %.3f\nPole Angle: %.3f rad (%.1f deg)\nReward: %.1f",
              current_step_, data_->qpos[0], data_->qpos[1], 
              data_->qpos[1] * 180.0 / M_PI, 
-             computeReward(getCurrentState(), isDone()));
+             computeReward(isDone()));
     mjr_overlay(mjFONT_NORMAL, mjGRID_TOPLEFT, viewport, info, nullptr, con_);
     
     // Swap buffers
@@ -221,13 +313,48 @@ void CartPoleEnv::close() {
 }
 
 std::vector<double> CartPoleEnv::getObservationSpaceLow() const {
+    if (custom_observation_ || getNumLinks() != 1) {
+        return observation_->low();
+    }
     return {-x_threshold_ * 2, -INFINITY, -theta_threshold_radians_ * 2, -INFINITY};
 }
 
 std::vector<double> CartPoleEnv::getObservationSpaceHigh() const {
+    if (custom_observation_ || getNumLinks() != 1) {
+        return observation_->high();
+    }
     return {x_threshold_ * 2, INFINITY, theta_threshold_radians_ * 2, INFINITY};
 }
 
+void CartPoleEnv::setRandomizer(std::shared_ptr<const DomainRandomizer> randomizer) {
+    randomizer_ = std::move(randomizer);
+    if (randomizer_ && randomizer_->getMode() == DomainRandomizer::Mode::PerEnvironment) {
+        setPhysicsVariant(randomizer_->sample(rng_));
+    }
+}
+
+void CartPoleEnv::setPhysicsVariant(const PhysicsVariant& variant) {
+    if (!randomizer_) {
+        throw std::runtime_error("setPhysicsVariant requires a DomainRandomizer");
+    }
+    variant_ = variant;
+    randomizer_->apply(variant_, model_, data_);
+}
+
+void CartPoleEnv::setInitialStateNoise(double half_width) {
+    if (half_width < 0.0) {
+        throw std::invalid_argument("Initial state noise must be non-negative");
+    }
+    uniform_dist_ = std::uniform_real_distribution<double>(-half_width, half_width);
+}
+
+void CartPoleEnv::setInitialStatePool(std::shared_ptr<const InitialStatePool> pool) {
+    if (pool && (pool->nq() != model_->nq || pool->nv() != model_->nv || pool->empty())) {
+        throw std::invalid_argument("Initial state pool does not match the model");
+    }
+    initial_states_ = std::move(pool);
+}
+
 bool CartPoleEnv::shouldClose() const {
     return render_enabled_ && window_ && glfwWindowShouldClose(window_);
 }
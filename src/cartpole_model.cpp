@@ -0,0 +1,100 @@
+#include "cartpole_model.h"
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string linkName(const char* base, int link) {
+    return link == 1 ? base : base + std::to_string(link);
+}
+
+}  // namespace
+
+std::string generateCartPoleXML(const CartPoleModelSpec& spec) {
+    if (spec.num_links < 1) {
+        throw std::invalid_argument("Cart-pole needs at least one link");
+    }
+
+    std::ostringstream xml;
+    xml << "<mujoco model=\"cartpole" << spec.num_links << "\">\n"
+        << "  <compiler inertiafromgeom=\"true\" angle=\"radian\" coordinate=\"local\"/>\n"
+        << "  <option timestep=\"" << spec.timestep << "\" gravity=\"0 0 -9.81\">\n"
+        << "    <flag constraint=\"disable\" energy=\"enable\"/>\n"
+        << "  </option>\n"
+        << "  <default>\n"
+        << "    <joint armature=\"0\" damping=\"0\" limited=\"false\"/>\n"
+        << "    <geom contype=\"0\" friction=\"1 0.1 0.1\" rgba=\"0.7 0.7 0 1\"/>\n"
+        << "  </default>\n"
+        << "  <worldbody>\n"
+        << "    <geom name=\"floor\" pos=\"0 0 -0.1\" size=\"10 10 0.1\" type=\"plane\""
+        << " rgba=\"0.8 0.9 0.8 1\" contype=\"1\" condim=\"3\"/>\n"
+        << "    <body name=\"cart\" pos=\"0 0 0\">\n"
+        << "      <joint name=\"slider\" type=\"slide\" pos=\"0 0 0\" axis=\"1 0 0\""
+        << " range=\"-2.4 2.4\" limited=\"true\"/>\n"
+        << "      <geom name=\"cart_geom\" type=\"box\" size=\"0.2 0.1 0.05\" pos=\"0 0 0\""
+        << " rgba=\"0.7 0.3 0.3 1\" mass=\"" << spec.cart_mass << "\"/>\n";
+
+    // Each link hangs off the end of the previous one; only the first hinge has the pi offset
+    std::string indent = "      ";
+    for (int link = 1; link <= spec.num_links; ++link) {
+        xml << indent << "<body name=\"" << linkName("pole", link) << "\" pos=\"0 0 "
+            << (link == 1 ? 0.0 : spec.link_length) << "\">\n"
+            << indent << "  <joint name=\"" << linkName("hinge", link)
+            << "\" type=\"hinge\" pos=\"0 0 0\" axis=\"0 1 0\""
+            << (link == 1 ? " ref=\"3.14159\"" : "") << "/>\n"
+            << indent << "  <geom name=\"" << linkName("pole", link) << "_geom\" type=\"capsule\""
+            << " fromto=\"0 0 0 0 0 " << spec.link_length << "\" size=\"" << spec.link_radius
+            << "\" rgba=\"0.3 0.3 0.7 1\" mass=\"" << spec.link_mass << "\"/>\n";
+        indent += "  ";
+    }
+    xml << indent << "<geom name=\"pole_tip\" type=\"sphere\" pos=\"0 0 " << spec.link_length
+        << "\" size=\"0.03\" rgba=\"0.9 0.1 0.1 1\" mass=\"" << spec.tip_mass << "\"/>\n";
+    for (int link = spec.num_links; link >= 1; --link) {
+        indent.resize(indent.size() - 2);
+        xml << indent << "</body>\n";
+    }
+
+    xml << "    </body>\n"
+        << "  </worldbody>\n"
+        << "  <actuator>\n"
+        << "    <motor name=\"cart_motor\" joint=\"slider\" gear=\"1\" ctrllimited=\"true\""
+        << " ctrlrange=\"" << -spec.max_force << " " << spec.max_force << "\"/>\n"
+        << "  </actuator>\n"
+        << "  <sensor>\n"
+        << "    <jointpos name=\"cart_pos\" joint=\"slider\"/>\n";
+    for (int link = 1; link <= spec.num_links; ++link) {
+        xml << "    <jointpos name=\"" << linkName("pole", link) << "_angle\" joint=\""
+            << linkName("hinge", link) << "\"/>\n";
+    }
+    xml << "    <jointvel name=\"cart_vel\" joint=\"slider\"/>\n";
+    for (int link = 1; link <= spec.num_links; ++link) {
+        xml << "    <jointvel name=\"" << linkName("pole", link) << "_angvel\" joint=\""
+            << linkName("hinge", link) << "\"/>\n";
+    }
+    xml << "  </sensor>\n"
+        << "</mujoco>\n";
+    return xml.str();
+}
+
+std::shared_ptr<const mjModel> buildCartPoleModel(const CartPoleModelSpec& spec) {
+    const std::string xml = generateCartPoleXML(spec);
+    const std::string filename = "cartpole" + std::to_string(spec.num_links) + ".xml";
+
+    // Compile from an in-memory virtual file system
+    mjVFS vfs;
+    mj_defaultVFS(&vfs);
+    if (mj_addBufferVFS(&vfs, filename.c_str(), xml.data(), static_cast<int>(xml.size())) != 0) {
+        mj_deleteVFS(&vfs);
+        throw std::runtime_error("Could not add generated model to the MuJoCo VFS");
+    }
+    char error[1000] = "Could not load model";
+    mjModel* model = mj_loadXML(filename.c_str(), &vfs, error, sizeof(error));
+    mj_deleteVFS(&vfs);
+    if (!model) {
+        throw std::runtime_error(std::string("Failed to compile generated cart-pole: ") + error);
+    }
+
+    return std::shared_ptr<const mjModel>(model, [](const mjModel* m) {
+        mj_deleteModel(const_cast<mjModel*>(m));
+    });
+}
@@ -0,0 +1,242 @@
+#include "checkpoint.h"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+size_t alignUp(size_t value) {
+    return (value + kCheckpointAlignment - 1) & ~(kCheckpointAlignment - 1);
+}
+
+void copyName(char* dest, size_t capacity, const std::string& name) {
+    if (name.size() >= capacity) {
+        throw std::invalid_argument("Checkpoint name too long: " + name);
+    }
+    std::memset(dest, 0, capacity);
+    std::memcpy(dest, name.data(), name.size());
+}
+
+void writeAll(int fd, const void* data, size_t bytes, const std::string& filepath) {
+    const char* ptr = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t written = ::write(fd, ptr, bytes);
+        if (written < 0) {
+            throw std::runtime_error("Failed to write checkpoint: " + filepath);
+        }
+        ptr += written;
+        bytes -= static_cast<size_t>(written);
+    }
+}
+
+// Make a rename into filepath's directory durable
+void syncDirectory(const std::string& filepath) {
+    size_t slash = filepath.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : filepath.substr(0, slash == 0 ? 1 : slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open checkpoint directory: " + dir);
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Failed to sync checkpoint directory: " + dir);
+    }
+}
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(const std::string& agent_name)
+    : agent_name_(agent_name), step_(0) {
+}
+
+void CheckpointWriter::addBlob(const std::string& name, BlobType type, const void* data, size_t bytes) {
+    for (const auto& blob : blobs_) {
+        if (blob.name == name) {
+            throw std::invalid_argument("Duplicate checkpoint blob: " + name);
+        }
+    }
+    blobs_.push_back({name, type, data, bytes});
+}
+
+void CheckpointWriter::commit(const std::string& filepath) const {
+    // Lay out the header, entry table and aligned blobs
+    CheckpointHeader header{};
+    header.magic = kCheckpointMagic;
+    header.version = kCheckpointVersion;
+    header.num_blobs = static_cast<uint32_t>(blobs_.size());
+    header.step = step_;
+    copyName(header.agent_name, sizeof(header.agent_name), agent_name_);
+
+    std::vector<BlobEntry> entries(blobs_.size());
+    size_t offset = alignUp(sizeof(CheckpointHeader) + entries.size() * sizeof(BlobEntry));
+    for (size_t i = 0; i < blobs_.size(); ++i) {
+        copyName(entries[i].name, sizeof(entries[i].name), blobs_[i].name);
+        entries[i].type = static_cast<uint32_t>(blobs_[i].type);
+        entries[i].reserved = 0;
+        entries[i].offset = offset;
+        entries[i].size = blobs_[i].bytes;
+        offset = alignUp(offset + blobs_[i].bytes);
+    }
+    header.file_size = offset;
+
+    // Write-then-rename: readers only ever see complete checkpoints. mkstemp gives
+    // every writer its own temporary, also for threads saving the same path.
+    std::string tmp_path = filepath + ".tmp.XXXXXX";
+    int fd = ::mkstemp(&tmp_path[0]);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open checkpoint for writing: " + filepath);
+    }
+    ::fchmod(fd, 0644);
+
+    try {
+        static const char padding[kCheckpointAlignment] = {};
+        size_t position = 0;
+        auto pad_to = [&](size_t target) {
+            writeAll(fd, padding, target - position, tmp_path);
+            position = target;
+        };
+
+        writeAll(fd, &header, sizeof(header), tmp_path);
+        writeAll(fd, entries.data(), entries.size() * sizeof(BlobEntry), tmp_path);
+        position = sizeof(header) + entries.size() * sizeof(BlobEntry);
+
+        for (size_t i = 0; i < blobs_.size(); ++i) {
+            pad_to(entries[i].offset);
+            writeAll(fd, blobs_[i].data, blobs_[i].bytes, tmp_path);
+            position += blobs_[i].bytes;
+        }
+        pad_to(header.file_size);
+
+        if (::fsync(fd) != 0) {
+            throw std::runtime_error("Failed to sync checkpoint: " + tmp_path);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    if (::rename(tmp_path.c_str(), filepath.c_str()) != 0) {
+        ::unlink(tmp_path.c_str());
+        throw std::runtime_error("Failed to publish checkpoint: " + filepath);
+    }
+    syncDirectory(filepath);
+}
+
+std::shared_ptr<const MappedCheckpoint> MappedCheckpoint::open(const std::string& filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open checkpoint: " + filepath);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CheckpointHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Invalid checkpoint file: " + filepath);
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Could not map checkpoint: " + filepath);
+    }
+
+    // Constructor validates the header and unmaps on failure
+    return std::shared_ptr<const MappedCheckpoint>(
+        new MappedCheckpoint(static_cast<const char*>(base), size));
+}
+
+MappedCheckpoint::MappedCheckpoint(const char* base, size_t size)
+    : base_(base), size_(size),
+      header_(reinterpret_cast<const CheckpointHeader*>(base)),
+      entries_(reinterpret_cast<const BlobEntry*>(base + sizeof(CheckpointHeader))) {
+    const char* error = nullptr;
+    if (header_->magic != kCheckpointMagic) {
+        error = "Not a checkpoint file";
+    } else if (header_->version != kCheckpointVersion) {
+        error = "Unsupported checkpoint version";
+    } else if (header_->file_size != size_ ||
+               sizeof(CheckpointHeader) + header_->num_blobs * sizeof(BlobEntry) > size_) {
+        error = "Truncated checkpoint file";
+    } else {
+        for (uint32_t i = 0; i < header_->num_blobs; ++i) {
+            if (entries_[i].name[sizeof(entries_[i].name) - 1] != '\0' ||
+                entries_[i].offset > size_ || entries_[i].size > size_ - entries_[i].offset) {
+                error = "Checkpoint blob out of bounds";
+                break;
+            }
+        }
+    }
+
+    if (error) {
+        ::munmap(const_cast<char*>(base_), size_);
+        throw std::runtime_error(error);
+    }
+}
+
+MappedCheckpoint::~MappedCheckpoint() {
+    ::munmap(const_cast<char*>(base_), size_);
+}
+
+bool MappedCheckpoint::has(const std::string& name) const {
+    for (uint32_t i = 0; i < header_->num_blobs; ++i) {
+        if (name == entries_[i].name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string MappedCheckpoint::agentName() const {
+    return std::string(header_->agent_name, strnlen(header_->agent_name, sizeof(header_->agent_name)));
+}
+
+std::string MappedCheckpoint::string(const std::string& name) const {
+    const BlobEntry& entry = find(name, BlobType::Bytes);
+    return std::string(base_ + entry.offset, entry.size);
+}
+
+const BlobEntry& MappedCheckpoint::find(const std::string& name, BlobType type) const {
+    for (uint32_t i = 0; i < header_->num_blobs; ++i) {
+        if (name == entries_[i].name) {
+            if (entries_[i].type != static_cast<uint32_t>(type)) {
+                throw std::runtime_error("Checkpoint blob has unexpected type: " + name);
+            }
+            return entries_[i];
+        }
+    }
+    throw std::runtime_error("Checkpoint blob not found: " + name);
+}
+
+CheckpointWatcher::CheckpointWatcher(const std::string& filepath)
+    : filepath_(filepath), last_inode_(0), last_mtime_ns_(0) {
+}
+
+std::shared_ptr<const MappedCheckpoint> CheckpointWatcher::poll() {
+    struct stat st;
+    if (::stat(filepath_.c_str(), &st) != 0) {
+        return nullptr;
+    }
+
+#ifdef __APPLE__
+    int64_t mtime_ns = static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    uint64_t inode = static_cast<uint64_t>(st.st_ino);
+    if (inode == last_inode_ && mtime_ns == last_mtime_ns_) {
+        return nullptr;
+    }
+
+    auto checkpoint = MappedCheckpoint::open(filepath_);
+    last_inode_ = inode;
+    last_mtime_ns_ = mtime_ns;
+    return checkpoint;
+}
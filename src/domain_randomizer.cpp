@@ -0,0 +1,141 @@
+#include "domain_randomizer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+int requireId(const mjModel* model, int type, const char* name) {
+    int id = mj_name2id(model, type, name);
+    if (id < 0) {
+        throw std::runtime_error(std::string("DomainRandomizer: model has no object named ") + name);
+    }
+    return id;
+}
+
+double sampleRange(const DomainRandomizer::Range& range, std::mt19937& rng) {
+    if (range.high <= range.low) {
+        return range.low;
+    }
+    return std::uniform_real_distribution<double>(range.low, range.high)(rng);
+}
+
+}  // namespace
+
+DomainRandomizer::DomainRandomizer(const mjModel* base_model, const Config& config)
+    : config_(config) {
+    cart_body_ = requireId(base_model, mjOBJ_BODY, "cart");
+    actuator_ = requireId(base_model, mjOBJ_ACTUATOR, "cart_motor");
+    cart_mass_ = base_model->body_mass[cart_body_];
+
+    // Every hinge moves one pole link: "pole"/"hinge", or pole2/hinge2, ... in N-link models
+    for (int j = 0; j < base_model->njnt; ++j) {
+        if (base_model->jnt_type[j] != mjJNT_HINGE) {
+            continue;
+        }
+        Link link;
+        link.body = base_model->jnt_bodyid[j];
+        link.dof = base_model->jnt_dofadr[j];
+        link.mass = base_model->body_mass[link.body];
+        link.damping = base_model->dof_damping[link.dof];
+        for (int i = 0; i < 3; ++i) {
+            link.pos[i] = base_model->body_pos[3 * link.body + i];
+            link.ipos[i] = base_model->body_ipos[3 * link.body + i];
+            link.inertia[i] = base_model->body_inertia[3 * link.body + i];
+        }
+        link.scale_pos = false;
+        for (const Link& parent : links_) {
+            link.scale_pos |= parent.body == base_model->body_parentid[link.body];
+        }
+        links_.push_back(link);
+    }
+    if (links_.empty()) {
+        throw std::runtime_error("DomainRandomizer: model has no hinge joints");
+    }
+
+    for (int g = 0; g < base_model->ngeom; ++g) {
+        for (const Link& link : links_) {
+            if (base_model->geom_bodyid[g] != link.body) {
+                continue;
+            }
+            pole_geoms_.push_back(g);
+            pole_geom_pos_.insert(pole_geom_pos_.end(), base_model->geom_pos + 3 * g,
+                                  base_model->geom_pos + 3 * g + 3);
+            pole_geom_size_.insert(pole_geom_size_.end(), base_model->geom_size + 3 * g,
+                                   base_model->geom_size + 3 * g + 3);
+        }
+    }
+
+    gear_ = base_model->actuator_gear[6 * actuator_];
+    timestep_ = base_model->opt.timestep;
+}
+
+PhysicsVariant DomainRandomizer::sample(std::mt19937& rng) const {
+    PhysicsVariant variant;
+    variant.cart_mass_scale = sampleRange(config_.cart_mass_scale, rng);
+    variant.pole_mass_scale = sampleRange(config_.pole_mass_scale, rng);
+    variant.pole_length_scale = sampleRange(config_.pole_length_scale, rng);
+    variant.joint_damping_scale = sampleRange(config_.joint_damping_scale, rng);
+    variant.actuator_gear_scale = sampleRange(config_.actuator_gear_scale, rng);
+    variant.timestep_scale = sampleRange(config_.timestep_scale, rng);
+    return variant;
+}
+
+std::vector<PhysicsVariant> DomainRandomizer::makeVariantTable(int count, unsigned int seed) const {
+    std::mt19937 rng(seed);
+    std::vector<PhysicsVariant> table;
+    table.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        table.push_back(sample(rng));
+    }
+    return table;
+}
+
+void DomainRandomizer::apply(const PhysicsVariant& variant, mjModel* model, mjData* data) const {
+    const double length = variant.pole_length_scale;
+
+    // Masses and lengths feed mj_setConst; only rerun it when one of them changes
+    bool changed = false;
+    auto set = [&changed](mjtNum& field, double value) {
+        changed |= field != value;
+        field = value;
+    };
+
+    set(model->body_mass[cart_body_], cart_mass_ * variant.cart_mass_scale);
+
+    // Each link: centre of mass moves with length; the two transverse principal
+    // inertias scale with mass * length^2, the axial one only with mass. A link
+    // hanging off the previous one moves with that link's end.
+    for (const Link& link : links_) {
+        set(model->body_mass[link.body], link.mass * variant.pole_mass_scale);
+        int axial = static_cast<int>(std::min_element(link.inertia, link.inertia + 3) - link.inertia);
+        for (int i = 0; i < 3; ++i) {
+            set(model->body_ipos[3 * link.body + i], link.ipos[i] * length);
+            double scale = variant.pole_mass_scale * (i == axial ? 1.0 : length * length);
+            set(model->body_inertia[3 * link.body + i], link.inertia[i] * scale);
+            if (link.scale_pos) {
+                set(model->body_pos[3 * link.body + i], link.pos[i] * length);
+            }
+        }
+        model->dof_damping[link.dof] = link.damping * variant.joint_damping_scale;
+    }
+
+    // Geometry follows the poles so rendering matches the dynamics
+    for (size_t k = 0; k < pole_geoms_.size(); ++k) {
+        int g = pole_geoms_[k];
+        for (int i = 0; i < 3; ++i) {
+            model->geom_pos[3 * g + i] = pole_geom_pos_[3 * k + i] * length;
+        }
+        if (model->geom_type[g] == mjGEOM_CAPSULE) {
+            model->geom_size[3 * g + 1] = pole_geom_size_[3 * k + 1] * length;
+        }
+    }
+
+    model->actuator_gear[6 * actuator_] = gear_ * variant.actuator_gear_scale;
+    model->opt.timestep = timestep_ * variant.timestep_scale;
+
+    // Recompute derived quantities (subtree masses, invweights, ...)
+    if (changed) {
+        mj_setConst(model, data);
+    }
+}
@@ -0,0 +1,33 @@
+#include "episode_arena.h"
+
+EpisodeArena::EpisodeArena(size_t initial_bytes)
+    : capacity_(initial_bytes), buffer_(new std::byte[initial_bytes]) {
+    resource_.emplace(buffer_.get(), capacity_, &overflow_);
+}
+
+void EpisodeArena::reset() {
+    // Grow once so the next episode of this size fits in the owned buffer
+    if (overflow_.bytes > 0) {
+        size_t grown = capacity_ + 2 * overflow_.bytes;
+        resource_.reset();
+        buffer_.reset(new std::byte[grown]);
+        capacity_ = grown;
+    }
+    overflow_.bytes = 0;
+
+    // Rewinding to the start of the buffer is O(1)
+    resource_.emplace(buffer_.get(), capacity_, &overflow_);
+}
+
+void* EpisodeArena::OverflowTracker::do_allocate(size_t size, size_t alignment) {
+    bytes += size;
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+}
+
+void EpisodeArena::OverflowTracker::do_deallocate(void* p, size_t size, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, size, alignment);
+}
+
+bool EpisodeArena::OverflowTracker::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
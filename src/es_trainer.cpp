@@ -0,0 +1,182 @@
+#include "es_trainer.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+ESTrainer::ESTrainer(EnvironmentFactory factory, std::shared_ptr<const NoiseTable> noise,
+                     const Config& config)
+    : factory_(std::move(factory)), noise_(std::move(noise)), config_(config),
+      steps_total_(nullptr), episodes_total_(nullptr), updates_total_(nullptr), mean_return_(nullptr) {
+    if (!factory_ || !noise_) {
+        throw std::invalid_argument("ESTrainer needs an environment factory and a noise table");
+    }
+    if (config_.population_pairs < 1 || config_.sigma <= 0.0) {
+        throw std::invalid_argument("ESTrainer needs at least one pair and a positive sigma");
+    }
+
+    int num_threads = config_.num_threads > 0
+        ? config_.num_threads
+        : std::max(1u, std::thread::hardware_concurrency());
+    workers_.resize(std::min(num_threads, config_.population_pairs));
+    for (auto& worker : workers_) {
+        worker.env = factory_();
+        worker.arena = std::make_unique<EpisodeArena>();
+        worker.env->setMemoryResource(worker.arena->resource());
+    }
+
+    if (config_.telemetry) {
+        Telemetry& telemetry = Telemetry::global();
+        steps_total_ = &telemetry.counter("cartpole_env_steps_total", "Environment steps");
+        episodes_total_ = &telemetry.counter("cartpole_episodes_total", "Completed episodes");
+        updates_total_ = &telemetry.counter("cartpole_learner_updates_total", "Parameter updates applied");
+        mean_return_ = &telemetry.gauge("es_generation_mean_return", "Mean return of the last ES generation");
+    }
+}
+
+double ESTrainer::rollout(Worker& worker, const ESAgent& agent, unsigned int seed, int& steps) {
+    // The previous rollout's States are gone, so its memory can be reused
+    worker.arena->reset();
+    worker.env->seed(seed);
+    State state = worker.env->reset();
+
+    double total_reward = 0.0;
+    int step = 0;
+    while (step < config_.max_steps) {
+        Action action = agent.policy(worker.params.data(), state, worker.scratch.data());
+        auto [next_state, reward, done, info] = worker.env->step(action);
+        total_reward += reward;
+        step++;
+        if (done) {
+            break;
+        }
+        state = std::move(next_state);
+    }
+    steps += step;
+    if (steps_total_) {
+        steps_total_->add(step);
+        episodes_total_->add();
+    }
+    return total_reward;
+}
+
+ESTrainer::Generation ESTrainer::step(ESAgent& agent) {
+    const size_t dim = agent.numParameters();
+    const int pairs = config_.population_pairs;
+    const float sigma = static_cast<float>(config_.sigma);
+    const float* theta = agent.parameters();
+
+    // Indices and episode seeds depend only on (seed, generation), so resumed runs replay exactly
+    const int64_t generation = agent.generation();
+    std::seed_seq seq{config_.seed, static_cast<unsigned int>(generation),
+                      static_cast<unsigned int>(generation >> 32)};
+    std::mt19937 rng(seq);
+    results_.resize(pairs);
+    for (auto& result : results_) {
+        result.noise_index = noise_->sampleIndex(rng, dim);
+    }
+    const unsigned int episode_seed = rng();
+
+    for (auto& worker : workers_) {
+        worker.params.resize(dim);
+        worker.scratch.resize(agent.scratchSize());
+    }
+
+    // Both members of a pair see the same episode seed (common random numbers)
+    std::atomic<int> next_pair(0);
+    auto work = [&](Worker& worker) {
+        for (int k = next_pair.fetch_add(1); k < pairs; k = next_pair.fetch_add(1)) {
+            PairResult& result = results_[k];
+            const float* eps = noise_->slice(result.noise_index);
+            unsigned int seed = episode_seed + static_cast<unsigned int>(k);
+            result.steps = 0;
+
+            for (size_t i = 0; i < dim; ++i) {
+                worker.params[i] = theta[i] + sigma * eps[i];
+            }
+            result.positive_return = rollout(worker, agent, seed, result.steps);
+            for (size_t i = 0; i < dim; ++i) {
+                worker.params[i] = theta[i] - sigma * eps[i];
+            }
+            result.negative_return = rollout(worker, agent, seed, result.steps);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers_.size(); ++t) {
+        threads.emplace_back(work, std::ref(workers_[t]));
+    }
+    work(workers_[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Reduce (index, R+, R-) with centered ranks over all 2N returns
+    returns_.resize(2 * pairs);
+    for (int k = 0; k < pairs; ++k) {
+        returns_[2 * k] = results_[k].positive_return;
+        returns_[2 * k + 1] = results_[k].negative_return;
+    }
+    centeredRanks(returns_, ranks_);
+
+    gradient_.assign(dim, 0.0f);
+    float* gradient = gradient_.data();
+    const float scale = 1.0f / (2.0f * pairs * sigma);
+    for (int k = 0; k < pairs; ++k) {
+        const float weight = static_cast<float>(ranks_[2 * k] - ranks_[2 * k + 1]) * scale;
+        const float* eps = noise_->slice(results_[k].noise_index);
+        for (size_t i = 0; i < dim; ++i) {
+            gradient[i] += weight * eps[i];
+        }
+    }
+    agent.applyGradient(gradient);
+
+    Generation stats;
+    stats.generation = agent.generation();
+    stats.mean_return = std::accumulate(returns_.begin(), returns_.end(), 0.0) / returns_.size();
+    auto [min_it, max_it] = std::minmax_element(returns_.begin(), returns_.end());
+    stats.min_return = *min_it;
+    stats.max_return = *max_it;
+    for (const auto& result : results_) {
+        stats.steps += result.steps;
+    }
+    if (updates_total_) {
+        updates_total_->add();
+        mean_return_->set(stats.mean_return);
+    }
+    return stats;
+}
+
+void ESTrainer::centeredRanks(const std::vector<double>& values, std::vector<double>& out) {
+    const size_t n = values.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return values[a] < values[b]; });
+
+    // Tied values share their average rank, so equal returns of an antithetic
+    // pair cancel instead of favouring one side
+    out.resize(n);
+    const double denom = n > 1 ? static_cast<double>(n - 1) : 1.0;
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        while (last < n && values[order[last]] == values[order[first]]) {
+            ++last;
+        }
+        const double rank = (first + last - 1) / 2.0;
+        for (size_t k = first; k < last; ++k) {
+            out[order[k]] = rank / denom - 0.5;
+        }
+        first = last;
+    }
+}
+
+void ESTrainer::printGeneration(const Generation& generation) {
+    std::cout << "Generation " << std::setw(5) << generation.generation
+              << " | Mean: " << std::fixed << std::setprecision(2) << generation.mean_return
+              << " | Min: " << generation.min_return
+              << " | Max: " << generation.max_return
+              << " | Steps: " << generation.steps << std::endl;
+}
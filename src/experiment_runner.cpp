@@ -1,20 +1,37 @@
 #include "experiment_runner.h"
 #include "environment_factory.h"
 #include "agent_factory.h"
+#include "policy_evaluator.h"
 #include <iostream>
 #include <iomanip>
 #include <numeric>
 #include <algorithm>
 #include <chrono>
 #include <thread>
+#include <sys/stat.h>
 
 ExperimentRunner::ExperimentRunner(std::unique_ptr<Environment> env, std::unique_ptr<Agent> agent)
-    : env_(std::move(env)), agent_(std::move(agent)) {
+    : env_(std::move(env)), agent_(std::move(agent)),
+      steps_total_(Telemetry::global().counter("cartpole_env_steps_total", "Environment steps")),
+      episodes_total_(Telemetry::global().counter("cartpole_episodes_total", "Completed episodes")),
+      episode_reward_(Telemetry::global().gauge("cartpole_episode_reward", "Reward of the last episode")),
+      episode_steps_(Telemetry::global().gauge("cartpole_episode_steps", "Length of the last episode")),
+      reward_moving_average_(Telemetry::global().gauge("cartpole_reward_moving_average",
+                                                       "Mean reward of the last 100 episodes")) {
     if (!env_ || !agent_) {
         throw std::runtime_error("Environment and Agent must be valid");
     }
 }
 
+void ExperimentRunner::setNormalizer(std::shared_ptr<Normalizer> normalizer) {
+    normalizer_worker_.reset();
+    normalizer_ = std::move(normalizer);
+    if (normalizer_) {
+        normalizer_worker_ = normalizer_->makeWorker();
+    }
+    agent_->setNormalizer(normalizer_);
+}
+
 std::vector<ExperimentRunner::EpisodeStats> ExperimentRunner::runExperiment(const ExperimentConfig& config) {
     std::vector<EpisodeStats> all_stats;
     all_stats.reserve(config.num_episodes);
@@ -24,6 +41,25 @@ std::vector<ExperimentRunner::EpisodeStats> ExperimentRunner::runExperiment(cons
     std::cout << "Agent: " << agent_->getName() << std::endl;
     std::cout << "================================" << std::endl;
     
+    // Metrics are sampled and served from a background thread
+    std::unique_ptr<TelemetryExporter> exporter;
+    if (config.telemetry_port != 0 || !config.telemetry_file.empty()) {
+        TelemetryExporter::Config telemetry_config;
+        telemetry_config.http_port = config.telemetry_port;
+        telemetry_config.file_path = config.telemetry_file;
+        exporter = std::make_unique<TelemetryExporter>(Telemetry::global(), telemetry_config);
+        if (exporter->httpPort() > 0) {
+            std::cout << "Telemetry: http://127.0.0.1:" << exporter->httpPort() << "/metrics" << std::endl;
+        }
+    }
+    
+    // Resume from the last published checkpoint
+    struct stat checkpoint_stat;
+    if (config.resume && stat(config.model_save_path.c_str(), &checkpoint_stat) == 0) {
+        agent_->loadModel(config.model_save_path);
+        std::cout << "Resumed from checkpoint: " << config.model_save_path << std::endl;
+    }
+    
     for (int episode = 0; episode < config.num_episodes; ++episode) {
         // Run episode
         bool should_render = config.render && (episode % config.render_frequency == 0);
@@ -31,6 +67,7 @@ std::vector<ExperimentRunner::EpisodeStats> ExperimentRunner::runExperiment(cons
         stats.episode = episode + 1;
         
         all_stats.push_back(stats);
+        reward_moving_average_.set(calculateMovingAverage(all_stats, 100));
         
         // Log progress
         if ((episode + 1) % config.log_frequency == 0) {
@@ -44,6 +81,12 @@ std::vector<ExperimentRunner::EpisodeStats> ExperimentRunner::runExperiment(cons
             std::cout << "--------------------------------" << std::endl;
         }
         
+        // Publish intermediate checkpoint (atomic, readers never see partial files)
+        if (config.checkpoint_frequency > 0 && (episode + 1) % config.checkpoint_frequency == 0 &&
+            !config.model_save_path.empty()) {
+            agent_->saveModel(config.model_save_path);
+        }
+        
         // Reset agent for next episode
         agent_->reset();
     }
@@ -78,6 +121,10 @@ std::vector<ExperimentRunner::EpisodeStats> ExperimentRunner::runExperimentFromC
     exp_config.log_file = config.get<std::string>("log_file", "experiment.log");
     exp_config.save_model = config.get<bool>("save_model", false);
     exp_config.model_save_path = config.get<std::string>("model_save_path", "model.bin");
+    exp_config.checkpoint_frequency = config.get<int>("checkpoint_frequency", 0);
+    exp_config.resume = config.get<bool>("resume", false);
+    exp_config.telemetry_port = config.get<int>("telemetry_port", 0);
+    exp_config.telemetry_file = config.get<std::string>("telemetry_file", "");
     
     return runExperiment(exp_config);
 }
@@ -89,8 +136,17 @@ ExperimentRunner::EpisodeStats ExperimentRunner::runEpisode(int max_steps, bool
     stats.terminated = false;
     stats.termination_reason = "";
     
-    // Reset environment
-    State state = env_->reset();
+    // Everything allocated during the previous episode is released at once
+    arena_.reset();
+    std::pmr::memory_resource* memory = arena_.resource();
+    
+    // Reset environment; its States come from the arena too, so moves stay moves
+    env_->setMemoryResource(memory);
+    State state(env_->reset(), memory);
+    if (normalizer_worker_) {
+        normalizer_worker_->setUpdating(agent_->isTraining());
+        normalizer_worker_->normalizeObservation(state);
+    }
     
     for (int step = 0; step < max_steps; ++step) {
         // Render if requested
@@ -105,9 +161,17 @@ ExperimentRunner::EpisodeStats ExperimentRunner::runEpisode(int max_steps, bool
         // Environment steps
         auto [next_state, reward, done, info] = env_->step(action);
         
-        // Create experience for learning
-        Experience exp(state, action, reward, next_state, done);
+        // Agent sees normalized observations and scaled rewards; stats keep raw reward
+        Reward learn_reward = reward;
+        if (normalizer_worker_) {
+            normalizer_worker_->normalizeObservation(next_state);
+            learn_reward = normalizer_worker_->scaleReward(reward, done);
+        }
+        
+        // Create experience for learning (allocated from the episode arena)
+        Experience exp(state, action, learn_reward, next_state, done, memory);
         agent_->learn(exp);
+        steps_total_.add();
         
         // Update stats
         stats.total_reward += reward;
@@ -122,9 +186,22 @@ ExperimentRunner::EpisodeStats ExperimentRunner::runEpisode(int max_steps, bool
         }
     }
     
+    // The arena is rewound next episode; States handed out after this come from the heap
+    env_->setMemoryResource(nullptr);
+    
+    // Publish normalization statistics gathered during the episode
+    if (normalizer_worker_) {
+        normalizer_worker_->endEpisode();
+        normalizer_->sync();
+    }
+    
     // Get agent statistics
     stats.agent_stats = agent_->getStats();
     
+    episodes_total_.add();
+    episode_reward_.set(stats.total_reward);
+    episode_steps_.set(stats.steps);
+    
     return stats;
 }
 
@@ -178,12 +255,22 @@ void ExperimentRunner::printSummary(const std::vector<EpisodeStats>& all_stats)
     }
     
     double avg_reward = total_reward / all_stats.size();
+    
+    // 95% bootstrap confidence interval of the mean episode reward
+    std::vector<double> rewards;
+    rewards.reserve(all_stats.size());
+    for (const auto& stats : all_stats) {
+        rewards.push_back(stats.total_reward);
+    }
+    auto [ci_low, ci_high] = PolicyEvaluator::bootstrapInterval(rewards, 0.95, 1000, 0);
+    
     double avg_steps = static_cast<double>(total_steps) / all_stats.size();
     double termination_rate = static_cast<double>(terminated_episodes) / all_stats.size();
     
     std::cout << "\n======== EXPERIMENT SUMMARY ========" << std::endl;
     std::cout << "Total Episodes: " << all_stats.size() << std::endl;
-    std::cout << "Average Reward: " << std::fixed << std::setprecision(2) << avg_reward << std::endl;
+    std::cout << "Average Reward: " << std::fixed << std::setprecision(2) << avg_reward
+              << " (95% CI [" << ci_low << ", " << ci_high << "])" << std::endl;
     std::cout << "Average Steps: " << std::fixed << std::setprecision(1) << avg_steps << std::endl;
     std::cout << "Termination Rate: " << std::fixed << std::setprecision(1) << (termination_rate * 100) << "%" << std::endl;
     std::cout << "=====================================" << std::endl;
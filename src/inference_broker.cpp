@@ -0,0 +1,222 @@
+#include "inference_broker.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, latency.count()));
+    buckets_[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns < kSubBuckets) {
+        return static_cast<int>(ns);
+    }
+    // Octave from the leading bit, sub-bucket from the two bits after it
+    int octave = 63 - __builtin_clzll(ns);
+    int sub = static_cast<int>((ns >> (octave - 2)) & (kSubBuckets - 1));
+    return octave * kSubBuckets + sub;
+}
+
+double LatencyHistogram::bucketUpperNanos(int index) {
+    if (index < kSubBuckets) {
+        return index + 1.0;
+    }
+    int octave = index / kSubBuckets;
+    int sub = index % kSubBuckets;
+    return std::ldexp(1.0 + (sub + 1.0) / kSubBuckets, octave);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t n = 0;
+    for (const auto& bucket : buckets_) {
+        n += bucket.load(std::memory_order_relaxed);
+    }
+    return n;
+}
+
+double LatencyHistogram::quantileMicros(double q) const {
+    uint64_t n = count();
+    if (n == 0) {
+        return 0.0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * n));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= std::max<uint64_t>(rank, 1)) {
+            return bucketUpperNanos(i) / 1000.0;
+        }
+    }
+    return bucketUpperNanos(kBuckets - 1) / 1000.0;
+}
+
+double LatencyHistogram::meanMicros() const {
+    uint64_t n = count();
+    return n > 0 ? total_ns_.load(std::memory_order_relaxed) / 1000.0 / n : 0.0;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total_ns_.store(0, std::memory_order_relaxed);
+}
+
+InferenceBroker::InferenceBroker(std::shared_ptr<Agent> agent)
+    : InferenceBroker(std::move(agent), Config()) {
+}
+
+InferenceBroker::InferenceBroker(std::shared_ptr<Agent> agent, const Config& config)
+    : agent_(std::move(agent)), config_(config), stopping_(false), requests_(0), batches_(0),
+      requests_total_(nullptr), batches_total_(nullptr), queue_depth_(nullptr),
+      batch_size_(nullptr), latency_p99_(nullptr) {
+    if (!agent_) {
+        throw std::invalid_argument("InferenceBroker needs an agent");
+    }
+    if (config_.max_batch < 1 || config_.max_delay_us < 0) {
+        throw std::invalid_argument("Invalid InferenceBroker configuration");
+    }
+
+    if (config_.telemetry) {
+        Telemetry& telemetry = Telemetry::global();
+        requests_total_ = &telemetry.counter("inference_requests_total", "Observations submitted to the broker");
+        batches_total_ = &telemetry.counter("inference_batches_total", "Batched forward passes");
+        queue_depth_ = &telemetry.gauge("inference_queue_depth", "Requests waiting after the last batch was taken");
+        batch_size_ = &telemetry.gauge("inference_batch_size", "Size of the last batch");
+        latency_p99_ = &telemetry.gauge("inference_latency_p99_microseconds",
+                                        "99th percentile submit-to-result latency");
+    }
+
+    queue_.reserve(config_.max_batch);
+    thread_ = std::thread(&InferenceBroker::run, this);
+}
+
+InferenceBroker::~InferenceBroker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_one();
+    thread_.join();
+}
+
+std::future<Action> InferenceBroker::submit(State state) {
+    Request request{std::move(state), std::promise<Action>(), Clock::now()};
+    std::future<Action> result = request.result.get_future();
+
+    size_t depth;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            throw std::runtime_error("InferenceBroker is shutting down");
+        }
+        queue_.push_back(std::move(request));
+        depth = queue_.size();
+    }
+    // Wake the broker for a new deadline or a full batch; otherwise it is already timing one
+    if (depth == 1 || depth == static_cast<size_t>(config_.max_batch)) {
+        ready_.notify_one();
+    }
+
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    if (requests_total_) {
+        requests_total_->add();
+    }
+    return result;
+}
+
+void InferenceBroker::run() {
+    const size_t max_batch = static_cast<size_t>(config_.max_batch);
+    const auto max_delay = std::chrono::microseconds(config_.max_delay_us);
+    std::vector<Request> batch;
+    std::vector<State> states;
+    std::vector<Action> actions;
+    batch.reserve(max_batch);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        ready_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // Stopping with nothing left to answer
+        }
+
+        // Wait for a full batch until the oldest request hits its deadline
+        const Clock::time_point deadline = queue_.front().submitted + max_delay;
+        ready_.wait_until(lock, deadline, [&] { return stopping_ || queue_.size() >= max_batch; });
+
+        if (queue_.size() <= max_batch) {
+            batch.swap(queue_);
+        } else {
+            std::move(queue_.begin(), queue_.begin() + max_batch, std::back_inserter(batch));
+            queue_.erase(queue_.begin(), queue_.begin() + max_batch);
+        }
+        if (queue_depth_) {
+            queue_depth_->set(static_cast<double>(queue_.size()));
+        }
+
+        lock.unlock();
+        process(batch, states, actions);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void InferenceBroker::process(std::vector<Request>& batch, std::vector<State>& states,
+                              std::vector<Action>& actions) {
+    states.clear();
+    for (Request& request : batch) {
+        states.push_back(std::move(request.state));
+    }
+    actions.resize(batch.size());
+
+    try {
+        agent_->actBatch(states.data(), states.size(), actions.data());
+    } catch (...) {
+        for (Request& request : batch) {
+            request.result.set_exception(std::current_exception());
+        }
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].result.set_value(actions[i]);
+        latency_.record(now - batch[i].submitted);
+    }
+
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    if (batches_total_) {
+        batches_total_->add();
+        batch_size_->set(static_cast<double>(batch.size()));
+        latency_p99_->set(latency_.quantileMicros(0.99));
+    }
+}
+
+double InferenceBroker::meanBatchSize() const {
+    uint64_t b = batches();
+    return b > 0 ? static_cast<double>(latency_.count()) / b : 0.0;
+}
+
+std::vector<std::pair<std::string, double>> InferenceBroker::getStats() const {
+    return {
+        {"requests", static_cast<double>(requests())},
+        {"batches", static_cast<double>(batches())},
+        {"mean_batch_size", meanBatchSize()},
+        {"latency_mean_us", latency_.meanMicros()},
+        {"latency_p50_us", latency_.quantileMicros(0.5)},
+        {"latency_p99_us", latency_.quantileMicros(0.99)}
+    };
+}
+
+BrokeredAgent::BrokeredAgent(std::shared_ptr<InferenceBroker> broker) : broker_(std::move(broker)) {
+    if (!broker_) {
+        throw std::invalid_argument("BrokeredAgent needs a broker");
+    }
+}
+
+std::unique_ptr<Agent> BrokeredAgent::clone() const {
+    return std::make_unique<BrokeredAgent>(broker_);
+}
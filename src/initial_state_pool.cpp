@@ -0,0 +1,66 @@
+#include "initial_state_pool.h"
+#include <algorithm>
+#include <stdexcept>
+
+InitialStatePool::InitialStatePool(int nq, int nv) : nq_(nq), nv_(nv) {
+    if (nq < 1 || nv < 0) {
+        throw std::invalid_argument("Invalid initial state dimensions");
+    }
+}
+
+InitialStatePool InitialStatePool::uniform(const mjModel* model, int count, double half_width,
+                                           unsigned int seed) {
+    InitialStatePool pool(model->nq, model->nv);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> noise(-half_width, half_width);
+    std::vector<double> qpos(model->nq);
+    std::vector<double> qvel(model->nv);
+    for (int n = 0; n < count; ++n) {
+        for (int i = 0; i < model->nq; ++i) {
+            qpos[i] = model->qpos0[i] + noise(rng);
+        }
+        for (int i = 0; i < model->nv; ++i) {
+            qvel[i] = noise(rng);
+        }
+        pool.add(qpos.data(), qvel.data());
+    }
+    return pool;
+}
+
+void InitialStatePool::add(const double* qpos, const double* qvel) {
+    states_.insert(states_.end(), qpos, qpos + nq_);
+    states_.insert(states_.end(), qvel, qvel + nv_);
+}
+
+int InitialStatePool::addTrajectories(const TrajectoryFile& file, int stride, int max_frames_from_end) {
+    if (file.nq() != nq_ || file.nv() != nv_) {
+        throw std::invalid_argument("Trajectory file does not match the initial state pool");
+    }
+    if (stride < 1) {
+        throw std::invalid_argument("Trajectory stride must be positive");
+    }
+
+    // Frames are [qpos | qvel | ctrl]; the first nq + nv values are a start state
+    std::vector<double> frames;
+    const int frame_size = file.frameSize();
+    int added = 0;
+    for (int e = 0; e < file.numEpisodes(); ++e) {
+        file.decodeEpisode(e, frames);
+        const int num_frames = file.numFrames(e);
+        const int first = max_frames_from_end >= 0 ? std::max(0, num_frames - max_frames_from_end) : 0;
+        for (int f = first; f < num_frames; f += stride) {
+            const double* frame = frames.data() + static_cast<size_t>(f) * frame_size;
+            add(frame, frame + nq_);
+            ++added;
+        }
+    }
+    return added;
+}
+
+const double* InitialStatePool::sample(std::mt19937& rng) const {
+    if (states_.empty()) {
+        throw std::runtime_error("Initial state pool is empty");
+    }
+    std::uniform_int_distribution<int> index(0, size() - 1);
+    return state(index(rng));
+}
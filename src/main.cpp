@@ -2,8 +2,13 @@
 #include <chrono>
 #include <thread>
 #include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <algorithm>
 #include "mujoco/mujoco.h"
 #include "GLFW/glfw3.h"
+#include "trajectory_recorder.h"
 
 // MuJoCo visualization structures
 mjvCamera cam;
@@ -25,12 +30,68 @@ bool button_right = false;
 double lastx = 0;
 double lasty = 0;
 
+// Replay of recorded trajectories (--replay file)
+std::unique_ptr<TrajectoryFile> replay;
+std::vector<double> replay_frames;
+int replay_episode = 0;
+double replay_frame = 0;
+double replay_speed = 1.0;
+bool replay_playing = true;
+
+// Decode an episode and rewind to its first frame
+void load_replay_episode(int episode) {
+    replay_episode = std::max(0, std::min(replay->numEpisodes() - 1, episode));
+    replay->decodeEpisode(replay_episode, replay_frames);
+    replay_frame = 0;
+}
+
+int replay_num_frames() {
+    return replay->numFrames(replay_episode);
+}
+
+// Write the current recorded frame into the simulation state
+void apply_replay_frame() {
+    int frame = std::max(0, std::min(replay_num_frames() - 1, static_cast<int>(replay_frame)));
+    const double* values = replay_frames.data() + static_cast<size_t>(frame) * replay->frameSize();
+    mju_copy(d->qpos, values, m->nq);
+    mju_copy(d->qvel, values + m->nq, m->nv);
+    mju_copy(d->ctrl, values + m->nq + m->nv, m->nu);
+    d->time = frame * replay->timestep();
+    mj_forward(m, d);
+}
+
+// Replay controls: space, arrows (scrub/speed), N/P episodes, Home/End
+void replay_keyboard(int key, int act, int mods) {
+    if (act != GLFW_PRESS && act != GLFW_REPEAT) {
+        return;
+    }
+    int last_frame = replay_num_frames() - 1;
+    int scrub = (mods & GLFW_MOD_SHIFT) ? 50 : 1;
+    switch (key) {
+        case GLFW_KEY_SPACE: replay_playing = !replay_playing; break;
+        case GLFW_KEY_RIGHT: replay_playing = false; replay_frame = std::min<double>(last_frame, replay_frame + scrub); break;
+        case GLFW_KEY_LEFT: replay_playing = false; replay_frame = std::max(0.0, replay_frame - scrub); break;
+        case GLFW_KEY_UP: replay_speed = std::min(64.0, replay_speed * 2.0); break;
+        case GLFW_KEY_DOWN: replay_speed = std::max(1.0 / 16.0, replay_speed / 2.0); break;
+        case GLFW_KEY_N: load_replay_episode(replay_episode + 1); break;
+        case GLFW_KEY_P: load_replay_episode(replay_episode - 1); break;
+        case GLFW_KEY_HOME: replay_frame = 0; break;
+        case GLFW_KEY_END: replay_frame = last_frame; break;
+        default: break;
+    }
+}
+
 // Keyboard callback
 void keyboard(GLFWwindow* window, int key, int scancode, int act, int mods) {
     if (act == GLFW_PRESS && key == GLFW_KEY_ESCAPE) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
     
+    if (replay) {
+        replay_keyboard(key, act, mods);
+        return;
+    }
+    
     // Reset simulation with 'R'
     if (act == GLFW_PRESS && key == GLFW_KEY_R) {
         mj_resetData(m, d);
@@ -99,6 +160,12 @@ void init_visualization() {
 }
 
 int main(int argc, char** argv) {
+    // Optional: cartpole --replay recording.traj
+    const char* replay_path = nullptr;
+    if (argc > 2 && std::strcmp(argv[1], "--replay") == 0) {
+        replay_path = argv[2];
+    }
+    
     // Load MuJoCo model
     char error[1000] = "Could not load model";
     m = mj_loadXML("mujoco/cartpole.xml", nullptr, error, sizeof(error));
@@ -110,6 +177,23 @@ int main(int argc, char** argv) {
     // Create data
     d = mj_makeData(m);
     
+    // Load recording (must come from the same model)
+    if (replay_path) {
+        try {
+            replay = std::make_unique<TrajectoryFile>(replay_path);
+        } catch (const std::exception& e) {
+            std::cerr << "Replay error: " << e.what() << std::endl;
+            return 1;
+        }
+        if (replay->nq() != m->nq || replay->nv() != m->nv || replay->nu() != m->nu ||
+            replay->numEpisodes() == 0) {
+            std::cerr << "Recording does not match model or contains no episodes" << std::endl;
+            return 1;
+        }
+        load_replay_episode(0);
+        apply_replay_frame();
+    }
+    
     // Initialize GLFW
     if (!glfwInit()) {
         mju_error("Could not initialize GLFW");
@@ -136,19 +220,40 @@ int main(int argc, char** argv) {
     mjr_makeContext(m, &con, mjFONTSCALE_150);
     
     // Print instructions
-    std::cout << "=== Cart-Pole Simulation ===" << std::endl;
-    std::cout << "Use arrow keys to apply force to cart" << std::endl;
-    std::cout << "Press 'R' to reset simulation" << std::endl;
-    std::cout << "Press 'ESC' to exit" << std::endl;
-    std::cout << "Mouse: drag to rotate camera" << std::endl;
-    std::cout << "===========================" << std::endl;
+    if (replay) {
+        std::cout << "=== Cart-Pole Replay ===" << std::endl;
+        std::cout << replay->numEpisodes() << " episodes in " << replay_path << std::endl;
+        std::cout << "Space: play/pause, Left/Right: scrub (Shift: 50 frames)" << std::endl;
+        std::cout << "Up/Down: speed, N/P: next/previous episode, Home/End: seek" << std::endl;
+        std::cout << "Press 'ESC' to exit" << std::endl;
+        std::cout << "========================" << std::endl;
+    } else {
+        std::cout << "=== Cart-Pole Simulation ===" << std::endl;
+        std::cout << "Use arrow keys to apply force to cart" << std::endl;
+        std::cout << "Press 'R' to reset simulation" << std::endl;
+        std::cout << "Press 'ESC' to exit" << std::endl;
+        std::cout << "Mouse: drag to rotate camera" << std::endl;
+        std::cout << "===========================" << std::endl;
+    }
     
     // Main simulation loop
     while (!glfwWindowShouldClose(window)) {
-        // Advance simulation
-        mjtNum simstart = d->time;
-        while (d->time - simstart < 1.0/60.0) {
-            mj_step(m, d);
+        if (replay) {
+            // Advance through recorded frames at speed x real time
+            if (replay_playing) {
+                replay_frame += replay_speed * (1.0 / 60.0) / replay->timestep();
+                if (replay_frame >= replay_num_frames() - 1) {
+                    replay_frame = replay_num_frames() - 1;
+                    replay_playing = false;
+                }
+            }
+            apply_replay_frame();
+        } else {
+            // Advance simulation
+            mjtNum simstart = d->time;
+            while (d->time - simstart < 1.0/60.0) {
+                mj_step(m, d);
+            }
         }
         
         // Get window size
@@ -169,6 +274,15 @@ int main(int argc, char** argv) {
                  d->time, d->qpos[0], d->qpos[1], d->qpos[1] * 180.0 / M_PI, d->qvel[0], d->qvel[1]);
         mjr_overlay(mjFONT_NORMAL, mjGRID_TOPLEFT, viewport, info, nullptr, &con);
         
+        if (replay) {
+            char status[128];
+            snprintf(status, sizeof(status), "Episode %d/%d\nFrame %d/%d\nSpeed %.3gx%s",
+                     replay_episode + 1, replay->numEpisodes(),
+                     static_cast<int>(replay_frame) + 1, replay_num_frames(),
+                     replay_speed, replay_playing ? "" : " (paused)");
+            mjr_overlay(mjFONT_NORMAL, mjGRID_TOPRIGHT, viewport, status, nullptr, &con);
+        }
+        
         // Swap buffers
         glfwSwapBuffers(window);
         glfwPollEvents();
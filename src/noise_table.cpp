@@ -0,0 +1,46 @@
+#include "noise_table.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+NoiseTable::NoiseTable(size_t size, unsigned int seed, int num_threads)
+    : noise_(size) {
+    if (size == 0) {
+        throw std::invalid_argument("NoiseTable size must be positive");
+    }
+
+    // Fixed-size chunks with their own seeds keep the table independent of thread count
+    const size_t chunk = 1 << 20;
+    const size_t num_chunks = (size + chunk - 1) / chunk;
+    int threads = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<int>(std::min<size_t>(threads, num_chunks));
+
+    auto fill = [&](int worker) {
+        for (size_t c = worker; c < num_chunks; c += threads) {
+            std::seed_seq seq{seed, static_cast<unsigned int>(c)};
+            std::mt19937 rng(seq);
+            std::normal_distribution<float> normal(0.0f, 1.0f);
+            size_t end = std::min(size, (c + 1) * chunk);
+            for (size_t i = c * chunk; i < end; ++i) {
+                noise_[i] = normal(rng);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t) {
+        workers.emplace_back(fill, t);
+    }
+    fill(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t NoiseTable::sampleIndex(std::mt19937& rng, size_t dim) const {
+    if (dim > noise_.size()) {
+        throw std::invalid_argument("NoiseTable smaller than parameter vector");
+    }
+    return std::uniform_int_distribution<size_t>(0, noise_.size() - dim)(rng);
+}
@@ -0,0 +1,290 @@
+#include "normalizer.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Holds an atomic_flag for its lifetime, also when the guarded code throws
+class FlagGuard {
+public:
+    explicit FlagGuard(std::atomic_flag& flag) : flag_(flag) {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+    ~FlagGuard() { flag_.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag& flag_;
+};
+
+}  // namespace
+
+RunningStats::RunningStats(int dim)
+    : count_(0.0), mean_(dim, 0.0), m2_(dim, 0.0), scratch_(2 * dim, 0.0) {
+}
+
+void RunningStats::update(const double* x) {
+    // Welford's single-sample update
+    count_ += 1.0;
+    const double inv_count = 1.0 / count_;
+    const int n = dim();
+    for (int i = 0; i < n; ++i) {
+        double delta = x[i] - mean_[i];
+        mean_[i] += delta * inv_count;
+        m2_[i] += delta * (x[i] - mean_[i]);
+    }
+}
+
+void RunningStats::updateBatch(const double* xs, int rows) {
+    if (rows <= 0) {
+        return;
+    }
+    const int n = dim();
+    double* batch_mean = scratch_.data();
+    double* batch_m2 = scratch_.data() + n;
+    std::fill(scratch_.begin(), scratch_.end(), 0.0);
+
+    // Two passes over contiguous rows; inner loops run across dimensions
+    for (int r = 0; r < rows; ++r) {
+        const double* row = xs + static_cast<size_t>(r) * n;
+        for (int i = 0; i < n; ++i) {
+            batch_mean[i] += row[i];
+        }
+    }
+    const double inv_rows = 1.0 / rows;
+    for (int i = 0; i < n; ++i) {
+        batch_mean[i] *= inv_rows;
+    }
+    for (int r = 0; r < rows; ++r) {
+        const double* row = xs + static_cast<size_t>(r) * n;
+        for (int i = 0; i < n; ++i) {
+            double delta = row[i] - batch_mean[i];
+            batch_m2[i] += delta * delta;
+        }
+    }
+
+    // Chan et al. combination of (count_, mean_, m2_) with the batch
+    const double total = count_ + rows;
+    const double weight = rows / total;
+    const double cross = count_ * rows / total;
+    for (int i = 0; i < n; ++i) {
+        double delta = batch_mean[i] - mean_[i];
+        mean_[i] += delta * weight;
+        m2_[i] += batch_m2[i] + delta * delta * cross;
+    }
+    count_ = total;
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count_ <= 0.0) {
+        return;
+    }
+    if (other.dim() != dim()) {
+        throw std::invalid_argument("RunningStats::merge dimension mismatch");
+    }
+
+    const double total = count_ + other.count_;
+    const double weight = other.count_ / total;
+    const double cross = count_ * other.count_ / total;
+    for (int i = 0; i < dim(); ++i) {
+        double delta = other.mean_[i] - mean_[i];
+        mean_[i] += delta * weight;
+        m2_[i] += other.m2_[i] + delta * delta * cross;
+    }
+    count_ = total;
+}
+
+void RunningStats::clear() {
+    count_ = 0.0;
+    std::fill(mean_.begin(), mean_.end(), 0.0);
+    std::fill(m2_.begin(), m2_.end(), 0.0);
+}
+
+void RunningStats::assign(double count, const double* mean, const double* m2) {
+    count_ = count;
+    std::copy(mean, mean + dim(), mean_.begin());
+    std::copy(m2, m2 + dim(), m2_.begin());
+}
+
+Normalizer::Normalizer(const Config& config)
+    : config_(config), mailboxes_(new Mailbox[config.max_workers]),
+      observations_(config.obs_dim), returns_(1) {
+    publish();
+}
+
+Normalizer::~Normalizer() {
+    for (int i = 0; i < config_.max_workers; ++i) {
+        delete mailboxes_[i].pending.exchange(nullptr);
+    }
+}
+
+std::unique_ptr<NormalizerWorker> Normalizer::makeWorker() {
+    // Claim a free slot; its mailbox may still hold the previous owner's last delta,
+    // which the new worker's first post() folds in
+    for (int slot = 0; slot < config_.max_workers; ++slot) {
+        bool expected = false;
+        if (mailboxes_[slot].in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return std::unique_ptr<NormalizerWorker>(new NormalizerWorker(this, slot));
+        }
+    }
+    throw std::runtime_error("Normalizer: too many workers");
+}
+
+void Normalizer::releaseSlot(int slot) {
+    mailboxes_[slot].in_use.store(false, std::memory_order_release);
+}
+
+void Normalizer::post(int slot, Delta* delta) {
+    // If the previous delta has not been consumed yet, fold it into this one
+    Delta* previous = mailboxes_[slot].pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (previous) {
+        delta->observations.merge(previous->observations);
+        delta->returns.merge(previous->returns);
+        delete previous;
+    }
+    mailboxes_[slot].pending.store(delta, std::memory_order_release);
+}
+
+bool Normalizer::sync() {
+    if (syncing_.test_and_set(std::memory_order_acquire)) {
+        return false;
+    }
+
+    for (int i = 0; i < config_.max_workers; ++i) {
+        Delta* delta = mailboxes_[i].pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (delta) {
+            observations_.merge(delta->observations);
+            returns_.merge(delta->returns);
+            delete delta;
+        }
+    }
+    publish();
+
+    syncing_.clear(std::memory_order_release);
+    return true;
+}
+
+void Normalizer::publish() {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->mean.assign(observations_.mean().begin(), observations_.mean().end());
+    snapshot->inv_std.resize(config_.obs_dim);
+    for (int i = 0; i < config_.obs_dim; ++i) {
+        snapshot->inv_std[i] = 1.0 / std::sqrt(observations_.variance(i) + config_.epsilon);
+    }
+    snapshot->reward_scale = 1.0 / std::sqrt(returns_.variance(0) + config_.epsilon);
+    snapshot->count = observations_.count();
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(snapshot)));
+}
+
+std::shared_ptr<const Normalizer::Snapshot> Normalizer::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void Normalizer::normalize(const Snapshot& snapshot, State& observation) const {
+    if (!config_.normalize_observations) {
+        return;
+    }
+    if (observation.size() < static_cast<size_t>(config_.obs_dim)) {
+        throw std::invalid_argument("Observation is smaller than the normalizer dimension");
+    }
+    double* x = observation.data();
+    const double* mean = snapshot.mean.data();
+    const double* inv_std = snapshot.inv_std.data();
+    const double clip = config_.clip;
+    for (int i = 0; i < config_.obs_dim; ++i) {
+        double z = (x[i] - mean[i]) * inv_std[i];
+        x[i] = std::min(std::max(z, -clip), clip);
+    }
+}
+
+void Normalizer::saveState(CheckpointWriter& writer) const {
+    // Copies are taken under syncing_, so a concurrent sync() cannot be half merged
+    FlagGuard guard(syncing_);
+    const double obs_count = observations_.count();
+    const double ret_count = returns_.count();
+    writer.addCopy("normalizer/obs_count", &obs_count, 1);
+    writer.addCopy("normalizer/obs_mean", observations_.mean().data(), observations_.dim());
+    writer.addCopy("normalizer/obs_m2", observations_.m2().data(), observations_.dim());
+    writer.addCopy("normalizer/ret_count", &ret_count, 1);
+    writer.addCopy("normalizer/ret_mean", returns_.mean().data(), 1);
+    writer.addCopy("normalizer/ret_m2", returns_.m2().data(), 1);
+}
+
+void Normalizer::loadState(const MappedCheckpoint& checkpoint) {
+    BlobView<double> obs_count = checkpoint.view<double>("normalizer/obs_count");
+    BlobView<double> obs_mean = checkpoint.view<double>("normalizer/obs_mean");
+    BlobView<double> obs_m2 = checkpoint.view<double>("normalizer/obs_m2");
+    BlobView<double> ret_count = checkpoint.view<double>("normalizer/ret_count");
+    BlobView<double> ret_mean = checkpoint.view<double>("normalizer/ret_mean");
+    BlobView<double> ret_m2 = checkpoint.view<double>("normalizer/ret_m2");
+    if (obs_mean.size != static_cast<size_t>(config_.obs_dim) || obs_m2.size != obs_mean.size ||
+        obs_count.size != 1 || ret_count.size != 1 || ret_mean.size != 1 || ret_m2.size != 1) {
+        throw std::runtime_error("Checkpoint normalizer does not match observation size");
+    }
+
+    FlagGuard guard(syncing_);
+    observations_.assign(obs_count[0], obs_mean.data, obs_m2.data);
+    returns_.assign(ret_count[0], ret_mean.data, ret_m2.data);
+    publish();
+}
+
+NormalizerWorker::NormalizerWorker(Normalizer* parent, int slot)
+    : parent_(parent), slot_(slot), updating_(true), dim_(parent->config_.obs_dim),
+      snapshot_(parent->snapshot()), batch_(kBatchRows * parent->config_.obs_dim),
+      batch_rows_(0), discounted_return_(0.0) {
+    delta_.reset(new Normalizer::Delta{RunningStats(dim_), RunningStats(1)});
+}
+
+NormalizerWorker::~NormalizerWorker() {
+    flush();
+    parent_->releaseSlot(slot_);
+}
+
+void NormalizerWorker::normalizeObservation(State& observation) {
+    if (observation.size() < static_cast<size_t>(dim_)) {
+        throw std::invalid_argument("Observation is smaller than the normalizer dimension");
+    }
+    const double* x = observation.data();
+
+    if (updating_) {
+        std::copy(x, x + dim_, batch_.data() + static_cast<size_t>(batch_rows_) * dim_);
+        if (++batch_rows_ == kBatchRows) {
+            flushBatch();
+        }
+    }
+
+    parent_->normalize(*snapshot_, observation);
+}
+
+double NormalizerWorker::scaleReward(Reward reward, Done done) {
+    const Normalizer::Config& config = parent_->config_;
+    if (updating_) {
+        discounted_return_ = discounted_return_ * config.gamma + reward;
+        delta_->returns.update(&discounted_return_);
+    }
+    if (done) {
+        discounted_return_ = 0.0;
+    }
+    return config.scale_rewards ? reward * snapshot_->reward_scale : reward;
+}
+
+void NormalizerWorker::flush() {
+    flushBatch();
+    if (delta_->observations.count() > 0.0 || delta_->returns.count() > 0.0) {
+        parent_->post(slot_, delta_.release());
+        delta_.reset(new Normalizer::Delta{RunningStats(dim_), RunningStats(1)});
+    }
+    snapshot_ = parent_->snapshot();
+}
+
+void NormalizerWorker::endEpisode() {
+    discounted_return_ = 0.0;
+    flush();
+}
+
+void NormalizerWorker::flushBatch() {
+    delta_->observations.updateBatch(batch_.data(), batch_rows_);
+    batch_rows_ = 0;
+}
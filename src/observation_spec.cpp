@@ -0,0 +1,168 @@
+#include "observation_spec.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+ObservationSpec& ObservationSpec::sensor(const std::string& name) {
+    features_.push_back({Source::Sensor, -1, name});
+    return *this;
+}
+
+ObservationSpec& ObservationSpec::qpos(int index) {
+    features_.push_back({Source::Qpos, index, ""});
+    return *this;
+}
+
+ObservationSpec& ObservationSpec::qvel(int index) {
+    features_.push_back({Source::Qvel, index, ""});
+    return *this;
+}
+
+ObservationSpec& ObservationSpec::sinCos(int qpos_index) {
+    features_.push_back({Source::SinCos, qpos_index, ""});
+    return *this;
+}
+
+ObservationSpec& ObservationSpec::energy() {
+    features_.push_back({Source::Energy, -1, ""});
+    return *this;
+}
+
+ObservationSpec& ObservationSpec::history(int frames) {
+    if (frames < 1) {
+        throw std::invalid_argument("Observation history needs at least one frame");
+    }
+    history_ = frames;
+    return *this;
+}
+
+ObservationSpec ObservationSpec::jointState(const mjModel* model) {
+    ObservationSpec spec;
+    for (int j = 0; j < model->njnt; ++j) {
+        if (model->jnt_type[j] != mjJNT_SLIDE && model->jnt_type[j] != mjJNT_HINGE) {
+            throw std::invalid_argument("jointState only supports slide and hinge joints");
+        }
+        spec.qpos(model->jnt_qposadr[j]).qvel(model->jnt_dofadr[j]);
+    }
+    return spec;
+}
+
+ObservationSpec ObservationSpec::cartPoleSensors() {
+    return ObservationSpec().sensor("cart_pos").sensor("cart_vel")
+                            .sensor("pole_angle").sensor("pole_angvel");
+}
+
+ObservationSpec ObservationSpec::swingUp() {
+    return ObservationSpec().qpos(0).qvel(0).sinCos(1).qvel(1);
+}
+
+ObservationPipeline::ObservationPipeline(const ObservationSpec& spec, const mjModel* model)
+    : frame_size_(0), history_(spec.historyLength()), needs_forward_(false) {
+    for (const auto& feature : spec.features()) {
+        switch (feature.source) {
+        case ObservationSpec::Source::Sensor: {
+            int id = mj_name2id(model, mjOBJ_SENSOR, feature.name.c_str());
+            if (id < 0) {
+                throw std::invalid_argument("Unknown sensor: " + feature.name);
+            }
+            // Acceleration-stage sensors are computed before integration and would lag
+            if (model->sensor_needstage[id] == mjSTAGE_ACC) {
+                throw std::invalid_argument("Acceleration-stage sensor not supported: " + feature.name);
+            }
+            addCopy(&mjData::sensordata, model->sensor_adr[id], model->sensor_dim[id]);
+            needs_forward_ = true;
+            break;
+        }
+        case ObservationSpec::Source::Qpos:
+        case ObservationSpec::Source::Qvel: {
+            bool is_qpos = feature.source == ObservationSpec::Source::Qpos;
+            if (feature.index < 0 || feature.index >= (is_qpos ? model->nq : model->nv)) {
+                throw std::invalid_argument("Observation index out of range");
+            }
+            addCopy(is_qpos ? &mjData::qpos : &mjData::qvel, feature.index, 1);
+            break;
+        }
+        case ObservationSpec::Source::SinCos:
+            if (feature.index < 0 || feature.index >= model->nq) {
+                throw std::invalid_argument("Observation index out of range");
+            }
+            ops_.push_back({OpKind::SinCos, &mjData::qpos, feature.index, 2});
+            low_.insert(low_.end(), 2, -1.0);
+            high_.insert(high_.end(), 2, 1.0);
+            break;
+        case ObservationSpec::Source::Energy:
+            if (!(model->opt.enableflags & mjENBL_ENERGY)) {
+                throw std::invalid_argument("Energy observation needs <flag energy=\"enable\"/>");
+            }
+            ops_.push_back({OpKind::Energy, nullptr, 0, 1});
+            low_.push_back(-INFINITY);
+            high_.push_back(INFINITY);
+            needs_forward_ = true;
+            break;
+        }
+    }
+
+    for (const Op& op : ops_) {
+        frame_size_ += op.count;
+    }
+    if (frame_size_ == 0) {
+        throw std::invalid_argument("Observation spec is empty");
+    }
+
+    // Every history frame shares the bounds of a single frame
+    const std::vector<double> frame_low = low_;
+    const std::vector<double> frame_high = high_;
+    for (int k = 1; k < history_; ++k) {
+        low_.insert(low_.end(), frame_low.begin(), frame_low.end());
+        high_.insert(high_.end(), frame_high.begin(), frame_high.end());
+    }
+}
+
+void ObservationPipeline::addCopy(mjtNum* mjData::* field, int address, int count) {
+    low_.insert(low_.end(), count, -INFINITY);
+    high_.insert(high_.end(), count, INFINITY);
+
+    // Extend the previous copy when it reads the values just before this one
+    if (!ops_.empty()) {
+        Op& last = ops_.back();
+        if (last.kind == OpKind::Copy && last.field == field && last.address + last.count == address) {
+            last.count += count;
+            return;
+        }
+    }
+    ops_.push_back({OpKind::Copy, field, address, count});
+}
+
+void ObservationPipeline::write(const mjData* data, double* out) const {
+    for (const Op& op : ops_) {
+        switch (op.kind) {
+        case OpKind::Copy:
+            std::memcpy(out, data->*op.field + op.address, op.count * sizeof(double));
+            break;
+        case OpKind::SinCos: {
+            double angle = (data->*op.field)[op.address];
+            out[0] = std::sin(angle);
+            out[1] = std::cos(angle);
+            break;
+        }
+        case OpKind::Energy:
+            out[0] = data->energy[0] + data->energy[1];
+            break;
+        }
+        out += op.count;
+    }
+}
+
+void ObservationPipeline::reset(const mjData* data, double* stacked) const {
+    write(data, stacked);
+    for (int k = 1; k < history_; ++k) {
+        std::memcpy(stacked + k * frame_size_, stacked, frame_size_ * sizeof(double));
+    }
+}
+
+void ObservationPipeline::push(const mjData* data, double* stacked) const {
+    if (history_ > 1) {
+        std::memmove(stacked + frame_size_, stacked, (history_ - 1) * frame_size_ * sizeof(double));
+    }
+    write(data, stacked);
+}
@@ -0,0 +1,310 @@
+#include "policy_evaluator.h"
+#include "normalizer.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+struct EvalWorker {
+    std::unique_ptr<Environment> env;
+    std::unique_ptr<Agent> agent;
+};
+
+double mean(const std::vector<double>& values) {
+    return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+double resampledMean(const std::vector<double>& values, std::mt19937& rng) {
+    std::uniform_int_distribution<size_t> pick(0, values.size() - 1);
+    double sum = 0.0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        sum += values[pick(rng)];
+    }
+    return sum / values.size();
+}
+
+// A tail narrower than one resample would silently turn the interval into [min, max]
+void requireResolvableTails(double confidence, int resamples) {
+    if (!(confidence > 0.0 && confidence < 1.0) ||
+        (1.0 - confidence) / 2.0 * std::max(resamples - 1, 0) < 1.0) {
+        throw std::invalid_argument("Too few bootstrap resamples for the confidence level");
+    }
+}
+
+std::pair<double, double> percentiles(std::vector<double>& estimates, double confidence) {
+    std::sort(estimates.begin(), estimates.end());
+    double tail = (1.0 - confidence) / 2.0;
+    size_t last = estimates.size() - 1;
+    size_t lo = static_cast<size_t>(std::floor(tail * last));
+    size_t hi = static_cast<size_t>(std::ceil((1.0 - tail) * last));
+    return {estimates[lo], estimates[std::min(hi, last)]};
+}
+
+double runEvalEpisode(EvalWorker& worker, const Normalizer* normalizer,
+                      const Normalizer::Snapshot* snapshot, unsigned int seed, int max_steps) {
+    worker.env->seed(seed);
+    worker.agent->reset();
+
+    State state = worker.env->reset();
+    if (snapshot) {
+        normalizer->normalize(*snapshot, state);
+    }
+
+    double total_reward = 0.0;
+    for (int step = 0; step < max_steps; ++step) {
+        Action action = worker.agent->act(state);
+        auto [next_state, reward, done, info] = worker.env->step(action);
+        total_reward += reward;
+        if (done) {
+            break;
+        }
+        state = std::move(next_state);
+        if (snapshot) {
+            normalizer->normalize(*snapshot, state);
+        }
+    }
+    return total_reward;
+}
+
+}  // namespace
+
+PolicyEvaluator::PolicyEvaluator(EnvironmentFactory factory, const Config& config)
+    : factory_(std::move(factory)), config_(config) {
+    if (!factory_) {
+        throw std::invalid_argument("PolicyEvaluator needs an environment factory");
+    }
+    if (config_.max_baseline_looks < 1) {
+        throw std::invalid_argument("PolicyEvaluator needs at least one baseline look");
+    }
+    requireResolvableTails(config_.confidence, config_.bootstrap_samples);
+}
+
+PolicyEvaluator::Result PolicyEvaluator::evaluate(const Agent& agent, int n_episodes,
+                                                  const std::vector<unsigned int>& seeds) const {
+    return run(agent, nullptr, n_episodes, seeds);
+}
+
+PolicyEvaluator::Result PolicyEvaluator::compare(const Agent& agent,
+                                                 const std::vector<double>& baseline_returns,
+                                                 int n_episodes,
+                                                 const std::vector<unsigned int>& seeds) const {
+    if (baseline_returns.size() < 2) {
+        throw std::invalid_argument("PolicyEvaluator::compare needs at least two baseline returns");
+    }
+    return run(agent, &baseline_returns, n_episodes, seeds);
+}
+
+PolicyEvaluator::Result PolicyEvaluator::run(const Agent& agent, const std::vector<double>* baseline,
+                                             int n_episodes,
+                                             const std::vector<unsigned int>& seeds) const {
+    if (!seeds.empty() && static_cast<int>(seeds.size()) < n_episodes) {
+        throw std::invalid_argument("PolicyEvaluator: fewer seeds than episodes");
+    }
+
+    int num_threads = config_.num_threads > 0
+        ? config_.num_threads
+        : std::max(1u, std::thread::hardware_concurrency());
+    num_threads = std::max(1, std::min(num_threads, n_episodes));
+    int round_size = config_.round_size > 0 ? config_.round_size : 2 * num_threads;
+
+    // Frozen copies: evaluation never changes the agent being evaluated
+    std::vector<EvalWorker> workers(num_threads);
+    for (auto& worker : workers) {
+        worker.env = factory_();
+        worker.agent = agent.clone();
+        if (!worker.agent) {
+            throw std::runtime_error(agent.getName() + " does not support clone()");
+        }
+        worker.agent->setTrainingMode(false);
+    }
+
+    // Observation statistics are frozen at the snapshot taken here
+    const Normalizer* normalizer = agent.getNormalizer();
+    std::shared_ptr<const Normalizer::Snapshot> snapshot;
+    if (normalizer) {
+        snapshot = normalizer->snapshot();
+    }
+
+    // Stopping checks happen at these episode counts
+    std::vector<int> checkpoints;
+    for (int completed = 0; completed < n_episodes;) {
+        completed = std::min(n_episodes, std::max(completed + round_size, config_.min_episodes));
+        checkpoints.push_back(completed);
+    }
+
+    // The baseline test is repeated, so its error rate is split over the looks
+    // (Bonferroni): each uses 1 - alpha / looks. Looks are capped and spread
+    // evenly over the checks (always including the last one), and the bootstrap
+    // grows so that each corrected tail still holds about 20 resamples.
+    std::vector<size_t> eligible;
+    for (size_t k = 0; k < checkpoints.size(); ++k) {
+        if (checkpoints[k] >= 2) {
+            eligible.push_back(k);
+        }
+    }
+    const int looks = std::min(static_cast<int>(eligible.size()), config_.max_baseline_looks);
+    std::vector<char> baseline_look(checkpoints.size(), 0);
+    for (int j = 1; j <= looks; ++j) {
+        baseline_look[eligible[(j * eligible.size() + looks - 1) / looks - 1]] = 1;
+    }
+    const double diff_confidence = 1.0 - (1.0 - config_.confidence) / std::max(looks, 1);
+    const double diff_tail = (1.0 - diff_confidence) / 2.0;
+    const int diff_resamples = std::max(config_.bootstrap_samples,
+                                        static_cast<int>(std::ceil(20.0 / diff_tail)) + 1);
+
+    Result result;
+    result.returns.resize(n_episodes);
+
+    // Workers keep claiming episodes across checks instead of idling at a barrier;
+    // episodes past the stopping point are discarded
+    std::atomic<int> next_episode(0);
+    std::atomic<bool> stop(false);
+    std::vector<char> finished(n_episodes, 0);
+    int finished_prefix = 0;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable progress;
+
+    auto work = [&](EvalWorker& worker) {
+        while (!stop.load(std::memory_order_relaxed)) {
+            int i = next_episode.fetch_add(1);
+            if (i >= n_episodes) {
+                break;
+            }
+            unsigned int seed = seeds.empty() ? config_.base_seed + i : seeds[i];
+            double episode_return;
+            try {
+                episode_return = runEvalEpisode(worker, normalizer, snapshot.get(), seed,
+                                                config_.max_steps);
+            } catch (...) {
+                // Hand the first failure to the caller instead of terminating
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                stop = true;
+                progress.notify_one();
+                break;
+            }
+            result.returns[i] = episode_return;
+            std::lock_guard<std::mutex> lock(mutex);
+            finished[i] = 1;
+            while (finished_prefix < n_episodes && finished[finished_prefix]) {
+                finished_prefix++;
+            }
+            progress.notify_one();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back(work, std::ref(workers[t]));
+    }
+
+    int completed = 0;
+    std::vector<double> returns;
+    for (size_t k = 0; k < checkpoints.size(); ++k) {
+        const int checkpoint = checkpoints[k];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            progress.wait(lock, [&] { return finished_prefix >= checkpoint || error; });
+            if (error) {
+                break;
+            }
+        }
+        completed = checkpoint;
+
+        // Sequential stopping check on the first completed episodes
+        returns.assign(result.returns.begin(), result.returns.begin() + completed);
+        result.episodes = completed;
+        result.mean = mean(returns);
+        if (completed < 2) {
+            result.ci_low = result.ci_high = result.mean;
+            continue;
+        }
+        std::tie(result.ci_low, result.ci_high) = bootstrapInterval(
+            returns, config_.confidence, config_.bootstrap_samples, config_.bootstrap_seed);
+
+        if (baseline && baseline_look[k]) {
+            result.has_baseline = true;
+            std::tie(result.diff_low, result.diff_high) = bootstrapDifference(
+                returns, *baseline, diff_confidence, diff_resamples, config_.bootstrap_seed);
+            if (result.diff_low > 0.0) {
+                result.stop_reason = "better than baseline";
+            } else if (result.diff_high < 0.0) {
+                result.stop_reason = "worse than baseline";
+            }
+        }
+        if (result.stop_reason.empty() && config_.target_half_width > 0.0 &&
+            (result.ci_high - result.ci_low) / 2.0 <= config_.target_half_width) {
+            result.stop_reason = "confidence interval within target";
+        }
+
+        if (!result.stop_reason.empty()) {
+            result.stopped_early = completed < n_episodes;
+            break;
+        }
+    }
+
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    if (result.stop_reason.empty()) {
+        result.stop_reason = "episode budget exhausted";
+    }
+    result.returns.resize(completed);
+    return result;
+}
+
+std::pair<double, double> PolicyEvaluator::bootstrapInterval(const std::vector<double>& samples,
+                                                             double confidence, int resamples,
+                                                             unsigned int seed) {
+    requireResolvableTails(confidence, resamples);
+    std::mt19937 rng(seed);
+    std::vector<double> estimates(resamples);
+    for (int b = 0; b < resamples; ++b) {
+        estimates[b] = resampledMean(samples, rng);
+    }
+    return percentiles(estimates, confidence);
+}
+
+std::pair<double, double> PolicyEvaluator::bootstrapDifference(const std::vector<double>& a,
+                                                               const std::vector<double>& b,
+                                                               double confidence, int resamples,
+                                                               unsigned int seed) {
+    requireResolvableTails(confidence, resamples);
+    std::mt19937 rng(seed);
+    std::vector<double> estimates(resamples);
+    for (int r = 0; r < resamples; ++r) {
+        estimates[r] = resampledMean(a, rng) - resampledMean(b, rng);
+    }
+    return percentiles(estimates, confidence);
+}
+
+void PolicyEvaluator::printResult(const Result& result) {
+    std::cout << "\n======== EVALUATION ========" << std::endl;
+    std::cout << "Episodes: " << result.episodes
+              << (result.stopped_early ? " (stopped early)" : "") << std::endl;
+    std::cout << "Mean Return: " << std::fixed << std::setprecision(2) << result.mean
+              << " [" << result.ci_low << ", " << result.ci_high << "]" << std::endl;
+    if (result.has_baseline) {
+        std::cout << "Difference to Baseline: [" << result.diff_low << ", "
+                  << result.diff_high << "]" << std::endl;
+    }
+    std::cout << "Stop Reason: " << result.stop_reason << std::endl;
+    std::cout << "============================" << std::endl;
+}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "checkpoint.h"
+#include "es_agent.h"
+#include "rollout_protocol.h"
+
+// Rollout coordinator: broadcasts the current policy to connected workers and
+// collects their trajectory chunks. With --spawn N it forks N local workers,
+// which makes the whole setup testable on one machine.
+
+namespace {
+
+struct CoordinatorOptions {
+    std::string listen = "unix:cartpole_rollout.sock";
+    std::string policy_path;          // ESAgent checkpoint, re-broadcast when republished
+    int spawn = 0;
+    long long total_steps = 1000000;  // 0 = run until interrupted
+    int hidden_size = 16;
+    std::vector<std::string> worker_args;
+};
+
+struct WorkerState {
+    std::unique_ptr<Connection> connection;
+    uint32_t id = 0;
+    bool ready = false;
+    long long steps = 0;
+};
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void usage() {
+    std::cerr << "Usage: rollout_coordinator [--listen ENDPOINT] [--spawn N] [--steps N]\n"
+              << "                           [--policy CHECKPOINT] [--hidden N] [-- WORKER_ARGS...]\n"
+              << "ENDPOINT is host:port or unix:/path" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, CoordinatorOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--") {
+            options.worker_args.assign(argv + i + 1, argv + argc);
+            return true;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--listen") {
+            options.listen = value;
+        } else if (arg == "--spawn") {
+            options.spawn = std::stoi(value);
+        } else if (arg == "--steps") {
+            options.total_steps = std::stoll(value);
+        } else if (arg == "--policy") {
+            options.policy_path = value;
+        } else if (arg == "--hidden") {
+            options.hidden_size = std::stoi(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// rollout_worker is expected next to this executable
+std::string workerPath(const char* argv0) {
+    std::string self = argv0;
+    size_t slash = self.rfind('/');
+    return (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/rollout_worker";
+}
+
+pid_t spawnWorker(const std::string& path, const Endpoint& endpoint, int id,
+                  const std::vector<std::string>& extra) {
+    std::vector<std::string> args = {path, "--connect", endpoint.toString(), "--id", std::to_string(id)};
+    args.insert(args.end(), extra.begin(), extra.end());
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(path.c_str(), argv.data());
+        std::perror("execv rollout_worker");
+        _exit(127);
+    }
+    return pid;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    CoordinatorOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+    std::signal(SIGINT, [](int) { stop_requested = 1; });
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<pid_t> children;
+    int status = 0;
+    try {
+        Listener listener(Endpoint::parse(options.listen));
+        std::cout << "Listening on " << listener.endpoint().toString() << std::endl;
+
+        // Current policy; a republished checkpoint becomes the next version
+        ESAgent::Config config;
+        config.hidden_size = options.hidden_size;
+        ESAgent agent(config);
+        std::unique_ptr<CheckpointWatcher> watcher;
+        if (!options.policy_path.empty()) {
+            watcher = std::make_unique<CheckpointWatcher>(options.policy_path);
+        }
+        uint64_t version = 0;
+        std::vector<uint8_t> policy_payload;
+        auto encodeCurrentPolicy = [&]() {
+            PolicyHeader header{version, static_cast<uint32_t>(agent.numParameters()),
+                                config.observation_size, config.hidden_size, config.angle_index,
+                                config.max_force};
+            encodePolicy(header, agent.parameters(), policy_payload);
+        };
+        if (watcher) {
+            if (auto checkpoint = watcher->poll()) {
+                agent.loadModel(checkpoint);
+            }
+        }
+        encodeCurrentPolicy();
+
+        for (int i = 0; i < options.spawn; ++i) {
+            children.push_back(spawnWorker(workerPath(argv[0]), listener.endpoint(), i,
+                                           options.worker_args));
+        }
+
+        std::vector<WorkerState> workers;
+        long long total_steps = 0;
+        long long total_episodes = 0;
+        long long stale_chunks = 0;
+        long long total_chunks = 0;
+        double recent_return_sum = 0.0;
+        long long recent_episodes = 0;
+        long long last_report_steps = 0;
+        auto last_report = std::chrono::steady_clock::now();
+
+        std::vector<pollfd> fds;
+        Message message;
+        while (!stop_requested && (options.total_steps == 0 || total_steps < options.total_steps)) {
+            fds.assign(1, {listener.fd(), POLLIN, 0});
+            for (auto& worker : workers) {
+                fds.push_back({worker.connection->fd(), POLLIN, 0});
+            }
+            if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR) {
+                throw std::runtime_error("poll failed");
+            }
+
+            if (fds[0].revents & POLLIN) {
+                workers.push_back({listener.accept()});
+            }
+
+            for (size_t w = 0; w < workers.size() && w + 1 < fds.size(); ++w) {
+                if (!(fds[w + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    continue;
+                }
+                WorkerState& worker = workers[w];
+                // A failing worker is dropped on its own; the others keep collecting
+                bool open = false;
+                try {
+                    open = worker.connection->pump();
+                    while (worker.connection->pop(message)) {
+                        if (message.type == MessageType::Hello) {
+                            HelloMessage hello{};
+                            std::memcpy(&hello, message.payload.data(),
+                                        std::min(sizeof(hello), message.payload.size()));
+                            worker.id = hello.worker_id;
+                            // The policy reads exactly observation_size inputs per step
+                            if (hello.observation_size !=
+                                static_cast<uint32_t>(config.observation_size)) {
+                                throw std::runtime_error(
+                                    "observation size " + std::to_string(hello.observation_size) +
+                                    " does not match the policy's " +
+                                    std::to_string(config.observation_size));
+                            }
+                            worker.ready = true;
+                            worker.connection->send(MessageType::Policy, policy_payload);
+                        } else if (message.type == MessageType::TrajectoryChunk) {
+                            TrajectoryChunkView chunk = decodeChunk(message);
+                            worker.steps += chunk.header.num_steps;
+                            total_steps += chunk.header.num_steps;
+                            total_episodes += chunk.header.num_episodes;
+                            total_chunks++;
+                            stale_chunks += chunk.header.policy_version < version;
+                            for (uint32_t e = 0; e < chunk.header.num_episodes; ++e) {
+                                recent_return_sum += chunk.episode_returns[e];
+                            }
+                            recent_episodes += chunk.header.num_episodes;
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Dropping worker " << worker.id << ": " << e.what() << std::endl;
+                    worker.connection.reset();
+                    continue;
+                }
+                if (!open) {
+                    std::cout << "Worker " << worker.id << " disconnected" << std::endl;
+                    worker.connection.reset();
+                }
+            }
+            workers.erase(std::remove_if(workers.begin(), workers.end(),
+                                         [](const WorkerState& w) { return !w.connection; }),
+                          workers.end());
+
+            // Republished checkpoint: bump the version and broadcast
+            if (watcher) {
+                if (auto checkpoint = watcher->poll()) {
+                    agent.loadModel(checkpoint);
+                    version++;
+                    encodeCurrentPolicy();
+                    for (auto& worker : workers) {
+                        if (!worker.ready) {
+                            continue;
+                        }
+                        try {
+                            worker.connection->send(MessageType::Policy, policy_payload);
+                        } catch (const std::exception& e) {
+                            std::cerr << "Dropping worker " << worker.id << ": " << e.what() << std::endl;
+                            worker.connection.reset();
+                        }
+                    }
+                    workers.erase(std::remove_if(workers.begin(), workers.end(),
+                                                 [](const WorkerState& w) { return !w.connection; }),
+                                  workers.end());
+                    std::cout << "Broadcast policy version " << version << std::endl;
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - last_report).count();
+            if (elapsed >= 1.0) {
+                std::cout << "Workers: " << workers.size()
+                          << " | Steps/s: " << std::fixed << std::setprecision(0)
+                          << (total_steps - last_report_steps) / elapsed
+                          << " | Episodes: " << total_episodes
+                          << " | Mean Return: " << std::setprecision(2)
+                          << (recent_episodes > 0 ? recent_return_sum / recent_episodes : 0.0)
+                          << " | Stale Chunks: " << stale_chunks << "/" << total_chunks
+                          << std::endl;
+                last_report = now;
+                last_report_steps = total_steps;
+                recent_return_sum = 0.0;
+                recent_episodes = 0;
+            }
+        }
+
+        for (auto& worker : workers) {
+            try {
+                worker.connection->send(MessageType::Shutdown, nullptr, 0);
+            } catch (const std::exception&) {
+                // Worker already gone
+            }
+        }
+        std::cout << "Collected " << total_steps << " steps in " << total_episodes
+                  << " episodes" << std::endl;
+    } catch (const std::exception& e) {
+        // Listener, poll or spawn failure; per-worker errors are handled above
+        std::cerr << "Error: " << e.what() << std::endl;
+        status = 1;
+        for (pid_t child : children) {
+            kill(child, SIGTERM);
+        }
+    }
+
+    for (pid_t child : children) {
+        waitpid(child, nullptr, 0);
+    }
+    return status;
+}
@@ -0,0 +1,380 @@
+#include "rollout_protocol.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+std::runtime_error socketError(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+template <typename T>
+void append(std::vector<uint8_t>& out, const T* data, size_t count) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+// Returns a pointer to count Ts at offset and advances it
+template <typename T>
+const T* take(const Message& message, size_t& offset, size_t count) {
+    size_t bytes = count * sizeof(T);
+    if (offset + bytes > message.payload.size()) {
+        throw std::runtime_error("Truncated rollout message");
+    }
+    const T* data = reinterpret_cast<const T*>(message.payload.data() + offset);
+    offset += bytes;
+    return data;
+}
+
+void setNoSigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#else
+    (void)fd;
+#endif
+}
+
+// Resolves a TCP endpoint into a socket address
+sockaddr_storage tcpAddress(const Endpoint& endpoint, socklen_t& length) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    std::string port = std::to_string(endpoint.port);
+    int status = getaddrinfo(endpoint.host.empty() ? nullptr : endpoint.host.c_str(),
+                             port.c_str(), &hints, &result);
+    if (status != 0 || !result) {
+        throw std::runtime_error("Could not resolve " + endpoint.toString() + ": " +
+                                 gai_strerror(status));
+    }
+    sockaddr_storage address{};
+    std::memcpy(&address, result->ai_addr, result->ai_addrlen);
+    length = result->ai_addrlen;
+    freeaddrinfo(result);
+    return address;
+}
+
+sockaddr_un unixAddress(const Endpoint& endpoint) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (endpoint.path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Unix socket path too long: " + endpoint.path);
+    }
+    std::strcpy(address.sun_path, endpoint.path.c_str());
+    return address;
+}
+
+}  // namespace
+
+void encodePolicy(const PolicyHeader& header, const float* parameters, std::vector<uint8_t>& out) {
+    out.clear();
+    append(out, &header, 1);
+    append(out, parameters, header.num_parameters);
+}
+
+PolicyView decodePolicy(const Message& message) {
+    if (message.type != MessageType::Policy) {
+        throw std::runtime_error("Expected a policy message");
+    }
+    size_t offset = 0;
+    PolicyView view;
+    std::memcpy(&view.header, take<uint8_t>(message, offset, sizeof(PolicyHeader)),
+                sizeof(PolicyHeader));
+    view.parameters = take<float>(message, offset, view.header.num_parameters);
+    return view;
+}
+
+TrajectoryChunkView decodeChunk(const Message& message) {
+    if (message.type != MessageType::TrajectoryChunk) {
+        throw std::runtime_error("Expected a trajectory chunk");
+    }
+    size_t offset = 0;
+    TrajectoryChunkView view;
+    std::memcpy(&view.header, take<uint8_t>(message, offset, sizeof(ChunkHeader)),
+                sizeof(ChunkHeader));
+    const size_t steps = view.header.num_steps;
+    view.observations = take<float>(message, offset, steps * view.header.observation_size);
+    view.actions = take<float>(message, offset, steps);
+    view.rewards = take<float>(message, offset, steps);
+    view.episode_returns = take<float>(message, offset, view.header.num_episodes);
+    view.dones = take<uint8_t>(message, offset, steps);
+    return view;
+}
+
+TrajectoryChunkBuilder::TrajectoryChunkBuilder(uint32_t worker_id, int observation_size)
+    : worker_id_(worker_id), observation_size_(observation_size) {
+}
+
+void TrajectoryChunkBuilder::add(const State& state, Action action, Reward reward, bool done) {
+    for (int i = 0; i < observation_size_; ++i) {
+        observations_.push_back(static_cast<float>(state[i]));
+    }
+    actions_.push_back(static_cast<float>(action));
+    rewards_.push_back(static_cast<float>(reward));
+    dones_.push_back(done ? 1 : 0);
+}
+
+void TrajectoryChunkBuilder::addEpisodeReturn(double episode_return) {
+    episode_returns_.push_back(static_cast<float>(episode_return));
+}
+
+void TrajectoryChunkBuilder::finish(uint64_t policy_version, std::vector<uint8_t>& out) {
+    ChunkHeader header{policy_version, worker_id_, static_cast<uint32_t>(actions_.size()),
+                       static_cast<uint32_t>(observation_size_),
+                       static_cast<uint32_t>(episode_returns_.size())};
+    out.clear();
+    append(out, &header, 1);
+    append(out, observations_.data(), observations_.size());
+    append(out, actions_.data(), actions_.size());
+    append(out, rewards_.data(), rewards_.size());
+    append(out, episode_returns_.data(), episode_returns_.size());
+    append(out, dones_.data(), dones_.size());
+
+    observations_.clear();
+    actions_.clear();
+    rewards_.clear();
+    episode_returns_.clear();
+    dones_.clear();
+}
+
+Endpoint Endpoint::parse(const std::string& text) {
+    Endpoint endpoint;
+    if (text.rfind("unix:", 0) == 0) {
+        endpoint.is_unix = true;
+        endpoint.path = text.substr(5);
+        if (endpoint.path.empty()) {
+            throw std::invalid_argument("Empty Unix socket path: " + text);
+        }
+        return endpoint;
+    }
+
+    std::string rest = text.rfind("tcp://", 0) == 0 ? text.substr(6) : text;
+    size_t colon = rest.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::invalid_argument("Expected host:port or unix:path, got " + text);
+    }
+    endpoint.host = rest.substr(0, colon);
+    endpoint.port = static_cast<uint16_t>(std::stoi(rest.substr(colon + 1)));
+    return endpoint;
+}
+
+std::string Endpoint::toString() const {
+    return is_unix ? "unix:" + path : host + ":" + std::to_string(port);
+}
+
+Connection::Connection(int fd) : fd_(fd), in_start_(0) {
+    setNoSigpipe(fd_);
+}
+
+Connection::~Connection() {
+    close(fd_);
+}
+
+std::unique_ptr<Connection> Connection::connect(const Endpoint& endpoint) {
+    int fd;
+    int status;
+    if (endpoint.is_unix) {
+        sockaddr_un address = unixAddress(endpoint);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw socketError("socket");
+        }
+        status = ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        socklen_t length;
+        sockaddr_storage address = tcpAddress(endpoint, length);
+        fd = socket(address.ss_family, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw socketError("socket");
+        }
+        status = ::connect(fd, reinterpret_cast<sockaddr*>(&address), length);
+        // Chunks and policies are written as whole frames; don't delay them
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    if (status < 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        throw socketError("Could not connect to " + endpoint.toString());
+    }
+    return std::make_unique<Connection>(fd);
+}
+
+void Connection::send(MessageType type, const void* payload, size_t bytes) {
+    if (bytes > kMaxMessageBytes) {
+        throw std::runtime_error("Rollout message too large");
+    }
+    MessageHeader header{kRolloutMagic, kRolloutVersion, static_cast<uint16_t>(type),
+                         static_cast<uint32_t>(bytes), 0};
+
+    // Header and payload in one gathered write, resumed after partial writes
+    iovec parts[2] = {{&header, sizeof(header)}, {const_cast<void*>(payload), bytes}};
+    msghdr msg{};
+    msg.msg_iov = parts;
+    msg.msg_iovlen = bytes > 0 ? 2 : 1;
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    while (msg.msg_iovlen > 0) {
+        ssize_t written = sendmsg(fd_, &msg, flags);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw socketError("Rollout send failed");
+        }
+        while (msg.msg_iovlen > 0 && static_cast<size_t>(written) >= msg.msg_iov[0].iov_len) {
+            written -= msg.msg_iov[0].iov_len;
+            msg.msg_iov++;
+            msg.msg_iovlen--;
+        }
+        if (msg.msg_iovlen > 0) {
+            msg.msg_iov[0].iov_base = static_cast<uint8_t*>(msg.msg_iov[0].iov_base) + written;
+            msg.msg_iov[0].iov_len -= written;
+        }
+    }
+}
+
+bool Connection::readSome(bool blocking) {
+    // Drop consumed bytes before growing the buffer
+    if (in_start_ > 0 && in_start_ * 2 >= in_.size()) {
+        in_.erase(in_.begin(), in_.begin() + in_start_);
+        in_start_ = 0;
+    }
+    size_t used = in_.size();
+    in_.resize(used + 65536);
+    ssize_t received;
+    do {
+        received = recv(fd_, in_.data() + used, 65536, blocking ? 0 : MSG_DONTWAIT);
+    } while (received < 0 && errno == EINTR);
+    in_.resize(used + std::max<ssize_t>(received, 0));
+
+    if (received == 0) {
+        return false;
+    }
+    if (received < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return true;
+        }
+        if (errno == ECONNRESET) {
+            return false;
+        }
+        throw socketError("Rollout receive failed");
+    }
+    return true;
+}
+
+bool Connection::pump() {
+    size_t before;
+    do {
+        before = in_.size() - in_start_;
+        if (!readSome(false)) {
+            return false;
+        }
+    } while (in_.size() - in_start_ > before);
+    return true;
+}
+
+bool Connection::pop(Message& message) {
+    const size_t available = in_.size() - in_start_;
+    if (available < sizeof(MessageHeader)) {
+        return false;
+    }
+    MessageHeader header;
+    std::memcpy(&header, in_.data() + in_start_, sizeof(header));
+    if (header.magic != kRolloutMagic || header.version != kRolloutVersion ||
+        header.payload_bytes > kMaxMessageBytes) {
+        throw std::runtime_error("Corrupt or incompatible rollout message");
+    }
+    if (available < sizeof(header) + header.payload_bytes) {
+        return false;
+    }
+
+    const uint8_t* payload = in_.data() + in_start_ + sizeof(header);
+    message.type = static_cast<MessageType>(header.type);
+    message.payload.assign(payload, payload + header.payload_bytes);
+    in_start_ += sizeof(header) + header.payload_bytes;
+    return true;
+}
+
+bool Connection::receive(Message& message) {
+    while (!pop(message)) {
+        if (!readSome(true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Listener::Listener(const Endpoint& endpoint) : fd_(-1), endpoint_(endpoint) {
+    int status;
+    if (endpoint.is_unix) {
+        sockaddr_un address = unixAddress(endpoint);
+        unlink(endpoint.path.c_str());
+        fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            throw socketError("socket");
+        }
+        status = bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        socklen_t length;
+        sockaddr_storage address = tcpAddress(endpoint, length);
+        fd_ = socket(address.ss_family, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            throw socketError("socket");
+        }
+        int one = 1;
+        setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        status = bind(fd_, reinterpret_cast<sockaddr*>(&address), length);
+    }
+    if (status < 0 || listen(fd_, 64) < 0) {
+        int saved = errno;
+        close(fd_);
+        errno = saved;
+        throw socketError("Could not listen on " + endpoint.toString());
+    }
+
+    if (!endpoint.is_unix && endpoint.port == 0) {
+        sockaddr_storage bound{};
+        socklen_t length = sizeof(bound);
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&bound), &length);
+        endpoint_.port = ntohs(bound.ss_family == AF_INET6
+            ? reinterpret_cast<sockaddr_in6*>(&bound)->sin6_port
+            : reinterpret_cast<sockaddr_in*>(&bound)->sin_port);
+    }
+}
+
+Listener::~Listener() {
+    close(fd_);
+    if (endpoint_.is_unix) {
+        unlink(endpoint_.path.c_str());
+    }
+}
+
+std::unique_ptr<Connection> Listener::accept() {
+    int fd;
+    do {
+        fd = ::accept(fd_, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        throw socketError("accept");
+    }
+    if (!endpoint_.is_unix) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return std::make_unique<Connection>(fd);
+}
@@ -0,0 +1,171 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include "cartpole_env.h"
+#include "episode_arena.h"
+#include "es_agent.h"
+#include "rollout_protocol.h"
+
+// Rollout worker: steps a CartPole environment with the latest policy from
+// the coordinator and streams trajectory chunks back
+
+namespace {
+
+struct WorkerOptions {
+    std::string connect = "unix:cartpole_rollout.sock";
+    std::string model_path = "mujoco/cartpole.xml";
+    uint32_t id = 0;
+    int chunk_steps = 256;
+    int max_episode_steps = 500;
+    unsigned int seed = 0;
+    std::string record_path;    // Also record every episode for cartpole --replay
+};
+
+void usage() {
+    std::cerr << "Usage: rollout_worker [--connect ENDPOINT] [--id N] [--chunk-steps N]\n"
+              << "                      [--max-steps N] [--model PATH] [--seed N] [--record PATH]\n"
+              << "ENDPOINT is host:port or unix:/path" << std::endl;
+}
+
+bool parseOptions(int argc, char** argv, WorkerOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--connect") {
+            options.connect = value;
+        } else if (arg == "--id") {
+            options.id = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--chunk-steps") {
+            options.chunk_steps = std::stoi(value);
+        } else if (arg == "--max-steps") {
+            options.max_episode_steps = std::stoi(value);
+        } else if (arg == "--model") {
+            options.model_path = value;
+        } else if (arg == "--seed") {
+            options.seed = static_cast<unsigned int>(std::stoul(value));
+        } else if (arg == "--record") {
+            options.record_path = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Build or update the local policy from a Policy message; shape is the
+// header the current agent was built from
+void applyPolicy(const Message& message, std::unique_ptr<ESAgent>& agent, PolicyHeader& shape) {
+    PolicyView policy = decodePolicy(message);
+    const PolicyHeader& header = policy.header;
+    if (!agent || header.num_parameters != shape.num_parameters ||
+        header.observation_size != shape.observation_size ||
+        header.hidden_size != shape.hidden_size || header.angle_index != shape.angle_index ||
+        header.max_force != shape.max_force) {
+        ESAgent::Config config;
+        config.observation_size = header.observation_size;
+        config.hidden_size = header.hidden_size;
+        config.angle_index = header.angle_index;
+        config.max_force = header.max_force;
+        agent = std::make_unique<ESAgent>(config);
+        if (agent->numParameters() != static_cast<int>(header.num_parameters)) {
+            throw std::runtime_error("Policy shape does not match its parameter count");
+        }
+    }
+    agent->setParameters(policy.parameters);
+    shape = header;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    WorkerOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 1;
+    }
+
+    try {
+        auto connection = Connection::connect(Endpoint::parse(options.connect));
+        std::shared_ptr<const mjModel> model = CartPoleEnv::loadModel(options.model_path);
+        CartPoleEnv env(model.get(), false);
+        env.seed(options.seed + options.id);
+        if (!options.record_path.empty()) {
+            env.setRecorder(std::make_shared<TrajectoryRecorder>(options.record_path, model.get()));
+        }
+
+        HelloMessage hello{options.id, static_cast<uint32_t>(getpid()),
+                           static_cast<uint32_t>(env.getObservationSpaceSize()), 0};
+        connection->send(MessageType::Hello, &hello, sizeof(hello));
+
+        // The first policy is the only one we wait for
+        std::unique_ptr<ESAgent> agent;
+        PolicyHeader policy{};
+        Message message;
+        while (!agent) {
+            if (!connection->receive(message) || message.type == MessageType::Shutdown) {
+                return 0;
+            }
+            if (message.type == MessageType::Policy) {
+                applyPolicy(message, agent, policy);
+            }
+        }
+
+        TrajectoryChunkBuilder chunk(options.id, env.getObservationSpaceSize());
+        std::vector<uint8_t> payload;
+
+        // Per-step States come from an arena that is rewound between episodes;
+        // chunks copy what they keep
+        EpisodeArena arena;
+        env.setMemoryResource(arena.resource());
+
+        for (;;) {
+            arena.reset();
+            State state = env.reset();
+            double episode_return = 0.0;
+            bool episode_end = false;
+
+            for (int episode_steps = 1; !episode_end; ++episode_steps) {
+                Action action = agent->act(state);
+                auto [next_state, reward, done, info] = env.step(action);
+                episode_end = done || episode_steps >= options.max_episode_steps;
+                chunk.add(state, action, reward, episode_end);
+                episode_return += reward;
+                if (episode_end) {
+                    chunk.addEpisodeReturn(episode_return);
+                } else {
+                    state = std::move(next_state);
+                }
+
+                if (static_cast<int>(chunk.numSteps()) < options.chunk_steps) {
+                    continue;
+                }
+
+                // Ship the chunk, then pick up any newer policy without blocking
+                chunk.finish(policy.version, payload);
+                connection->send(MessageType::TrajectoryChunk, payload);
+
+                bool open = connection->pump();
+                while (connection->pop(message)) {
+                    if (message.type == MessageType::Shutdown) {
+                        return 0;
+                    }
+                    if (message.type == MessageType::Policy) {
+                        applyPolicy(message, agent, policy);
+                    }
+                }
+                if (!open) {
+                    return 0;
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Worker " << options.id << " error: " << e.what() << std::endl;
+        return 1;
+    }
+}
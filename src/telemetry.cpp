@@ -0,0 +1,268 @@
+#include "telemetry.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t Telemetry::Counter::value() const {
+    uint64_t sum = 0;
+    for (const Shard& shard : shards_) {
+        sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+int Telemetry::shardIndex() {
+    // Threads take shards round-robin on first use
+    static std::atomic<int> next_shard(0);
+    thread_local int shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+}
+
+Telemetry& Telemetry::global() {
+    static Telemetry telemetry;
+    return telemetry;
+}
+
+Telemetry::Counter& Telemetry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& entry : entries_) {
+        if (entry.name == name) {
+            if (entry.type != Type::Counter) {
+                throw std::invalid_argument("Metric registered as a gauge: " + name);
+            }
+            return *entry.counter;
+        }
+    }
+    counters_.emplace_back();
+    entries_.push_back({name, help, Type::Counter, &counters_.back(), nullptr});
+    return counters_.back();
+}
+
+Telemetry::Gauge& Telemetry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Entry& entry : entries_) {
+        if (entry.name == name) {
+            if (entry.type != Type::Gauge) {
+                throw std::invalid_argument("Metric registered as a counter: " + name);
+            }
+            return *entry.gauge;
+        }
+    }
+    gauges_.emplace_back();
+    entries_.push_back({name, help, Type::Gauge, nullptr, &gauges_.back()});
+    return gauges_.back();
+}
+
+std::vector<Telemetry::Sample> Telemetry::collect() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Sample> samples;
+    samples.reserve(entries_.size());
+    for (const Entry& entry : entries_) {
+        if (entry.type == Type::Counter) {
+            uint64_t count = entry.counter->value();
+            samples.push_back({entry.name, entry.help, entry.type, static_cast<double>(count), count});
+        } else {
+            samples.push_back({entry.name, entry.help, entry.type, entry.gauge->value(), 0});
+        }
+    }
+    return samples;
+}
+
+TelemetryExporter::TelemetryExporter(Telemetry& telemetry, const Config& config)
+    : telemetry_(telemetry), config_(config), listen_fd_(-1), bound_port_(0), running_(true) {
+    if (config_.interval_seconds <= 0.0) {
+        throw std::invalid_argument("Telemetry interval must be positive");
+    }
+
+    if (config_.http_port != 0) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(config_.http_port > 0 ? config_.http_port : 0));
+        if (inet_pton(AF_INET, config_.http_address.c_str(), &address.sin_addr) != 1) {
+            throw std::invalid_argument("Invalid telemetry address: " + config_.http_address);
+        }
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        if (listen_fd_ < 0 ||
+            setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0 ||
+            bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+            listen(listen_fd_, 16) < 0) {
+            std::string error = std::strerror(errno);
+            if (listen_fd_ >= 0) {
+                close(listen_fd_);
+            }
+            throw std::runtime_error("Could not open telemetry endpoint: " + error);
+        }
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        bound_port_ = ntohs(address.sin_port);
+    }
+
+    thread_ = std::thread(&TelemetryExporter::run, this);
+}
+
+TelemetryExporter::~TelemetryExporter() {
+    running_ = false;
+    thread_.join();
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+}
+
+std::string TelemetryExporter::latest() const {
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    return text_;
+}
+
+void TelemetryExporter::run() {
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config_.interval_seconds));
+
+    std::map<std::string, double> previous;
+    auto last_sample = Clock::now();
+    sample(previous, 0.0);
+
+    while (running_) {
+        auto now = Clock::now();
+        if (now - last_sample >= interval) {
+            sample(previous, std::chrono::duration<double>(now - last_sample).count());
+            last_sample = now;
+        }
+
+        // Wait for a scrape until the next sample is due (bounded so shutdown is prompt)
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(last_sample + interval - now);
+        int timeout_ms = static_cast<int>(std::max<long long>(1, std::min<long long>(100, wait.count())));
+        if (listen_fd_ < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            continue;
+        }
+        pollfd fd{listen_fd_, POLLIN, 0};
+        if (poll(&fd, 1, timeout_ms) > 0 && (fd.revents & POLLIN)) {
+            int client = accept(listen_fd_, nullptr, nullptr);
+            if (client >= 0) {
+                serve(client);
+                close(client);
+            }
+        }
+    }
+}
+
+void TelemetryExporter::sample(std::map<std::string, double>& previous, double elapsed_seconds) {
+    std::vector<Telemetry::Sample> samples = telemetry_.collect();
+    std::string text = renderPrometheus(samples, previous, elapsed_seconds);
+    for (const auto& s : samples) {
+        if (s.type == Telemetry::Type::Counter) {
+            previous[s.name] = s.value;
+        }
+    }
+
+    if (!config_.file_path.empty()) {
+        // Readers see the previous or the new file, never a partial one; mkstemp
+        // keeps exporters that share a path from writing the same temporary
+        std::string tmp_path = config_.file_path + ".tmp.XXXXXX";
+        int fd = mkstemp(&tmp_path[0]);
+        if (fd >= 0) {
+            fchmod(fd, 0644);
+            size_t written = 0;
+            while (written < text.size()) {
+                ssize_t n = write(fd, text.data() + written, text.size() - written);
+                if (n <= 0) {
+                    break;
+                }
+                written += n;
+            }
+            close(fd);
+            if (written != text.size() || std::rename(tmp_path.c_str(), config_.file_path.c_str()) != 0) {
+                unlink(tmp_path.c_str());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    text_ = std::move(text);
+}
+
+void TelemetryExporter::serve(int client_fd) const {
+    // Only the request line matters; bound the wait for a slow client
+    pollfd fd{client_fd, POLLIN, 0};
+    char request[1024];
+    ssize_t received = 0;
+    if (poll(&fd, 1, 200) > 0) {
+        received = recv(client_fd, request, sizeof(request) - 1, 0);
+    }
+    request[std::max<ssize_t>(received, 0)] = '\0';
+
+    std::string body;
+    std::string status = "200 OK";
+    if (std::strncmp(request, "GET /metrics", 12) == 0 || std::strncmp(request, "GET / ", 6) == 0) {
+        body = latest();
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << "\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    std::string bytes = response.str();
+    size_t sent = 0;
+    while (sent < bytes.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = send(client_fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = send(client_fd, bytes.data() + sent, bytes.size() - sent, 0);
+#endif
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+}
+
+std::string TelemetryExporter::renderPrometheus(const std::vector<Telemetry::Sample>& samples,
+                                                const std::map<std::string, double>& previous,
+                                                double elapsed_seconds) {
+    std::ostringstream out;
+    out.precision(10);
+    for (const auto& s : samples) {
+        const bool counter = s.type == Telemetry::Type::Counter;
+        out << "# HELP " << s.name << " " << s.help << "\n"
+            << "# TYPE " << s.name << (counter ? " counter" : " gauge") << "\n";
+        if (!counter) {
+            out << s.name << " " << s.value << "\n";
+            continue;
+        }
+        // Counters are integers; printed as doubles they would lose digits
+        out << s.name << " " << s.count << "\n";
+
+        // foo_total -> foo_per_second over the last sampling interval
+        std::string base = s.name;
+        if (base.size() > 6 && base.compare(base.size() - 6, 6, "_total") == 0) {
+            base.resize(base.size() - 6);
+        }
+        auto it = previous.find(s.name);
+        double rate = (it != previous.end() && elapsed_seconds > 0.0)
+            ? (s.value - it->second) / elapsed_seconds
+            : 0.0;
+        out << "# HELP " << base << "_per_second Rate of " << s.name << "\n"
+            << "# TYPE " << base << "_per_second gauge\n"
+            << base << "_per_second " << rate << "\n";
+    }
+    return out.str();
+}
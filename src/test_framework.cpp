@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "cartpole_dynamics.h"
+#include "cartpole_env.h"
+#include "es_agent.h"
+#include "normalizer.h"
+#include "rollout_protocol.h"
+#include "tile_coding_agent.h"
+#include "trajectory_recorder.h"
+
+// Behavior checks for the framework library: analytic dynamics against
+// MuJoCo, the wire and file codecs, statistics merging and checkpoints.
+// Runs from the repository root (ctest sets the working directory).
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+bool near(double a, double b, double tolerance) {
+    return std::abs(a - b) <= tolerance * (1.0 + std::abs(b));
+}
+
+// Scratch file path that is removed when the guard goes out of scope
+class TempFile {
+public:
+    TempFile() {
+        char name[] = "/tmp/cartpole_test_XXXXXX";
+        int fd = mkstemp(name);
+        if (fd < 0) {
+            throw std::runtime_error("mkstemp failed");
+        }
+        close(fd);
+        path_ = name;
+    }
+    ~TempFile() { std::remove(path_.c_str()); }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+void checkDynamics(const mjModel* model) {
+    CartPoleDynamics dynamics(model);
+    mjData* data = mj_makeData(model);
+
+    // Same open-loop forces through both simulators, including saturated ones
+    mj_resetData(model, data);
+    data->qpos[1] += 0.3;
+    double state[4] = {data->qpos[0], data->qvel[0], data->qpos[1], data->qvel[1]};
+    double next[4];
+    double max_error = 0.0;
+    for (int t = 0; t < 300; ++t) {
+        const double force = 12.0 * std::sin(0.05 * t);
+        data->ctrl[0] = force;
+        mj_step(model, data);
+        dynamics.step(state, force, next);
+        std::copy(next, next + 4, state);
+        const double mujoco_state[4] = {data->qpos[0], data->qvel[0], data->qpos[1], data->qvel[1]};
+        for (int i = 0; i < 4; ++i) {
+            max_error = std::max(max_error, std::abs(mujoco_state[i] - state[i]));
+        }
+    }
+    mj_deleteData(data);
+    check(max_error < 1e-6, "CartPoleDynamics::step matches mj_step (max error " +
+                                std::to_string(max_error) + ")");
+
+    // Forward-mode Jacobians against central differences
+    const double point[4] = {0.1, -0.2, dynamics.parameters().qpos0[1] + 0.4, 0.7};
+    const double ctrl = 3.0;
+    double A[16], B[4];
+    dynamics.jacobians(point, ctrl, A, B);
+
+    const double eps = 1e-6;
+    double plus[4], minus[4], perturbed[4];
+    for (int j = 0; j < 5; ++j) {
+        std::copy(point, point + 4, perturbed);
+        double u = ctrl;
+        (j < 4 ? perturbed[j] : u) += eps;
+        dynamics.step(perturbed, u, plus);
+        (j < 4 ? perturbed[j] : u) -= 2.0 * eps;
+        dynamics.step(perturbed, u, minus);
+        for (int i = 0; i < 4; ++i) {
+            const double numeric = (plus[i] - minus[i]) / (2.0 * eps);
+            const double analytic = j < 4 ? A[4 * i + j] : B[i];
+            check(near(analytic, numeric, 1e-6),
+                  "jacobians() entry (" + std::to_string(i) + ", " + std::to_string(j) +
+                      ") matches finite differences");
+        }
+    }
+
+    // The analytic model describes a force on the slider only
+    mjModel* wrong = mj_copyModel(nullptr, model);
+    wrong->actuator_trnid[0] = 1;
+    bool rejected = false;
+    try {
+        CartPoleDynamics::parametersFromModel(wrong);
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    mj_deleteModel(wrong);
+    check(rejected, "parametersFromModel rejects an actuator on the hinge");
+}
+
+void checkRolloutProtocol() {
+    const std::vector<float> parameters = {0.5f, -1.25f, 3.0f};
+    PolicyHeader header{7, static_cast<uint32_t>(parameters.size()), 4, 16, 2, 12.5};
+    Message message{MessageType::Policy, {}};
+    encodePolicy(header, parameters.data(), message.payload);
+
+    PolicyView policy = decodePolicy(message);
+    check(policy.header.version == 7 && policy.header.num_parameters == 3 &&
+              policy.header.observation_size == 4 && policy.header.hidden_size == 16 &&
+              policy.header.angle_index == 2 && policy.header.max_force == 12.5,
+          "policy header round-trips");
+    check(std::equal(parameters.begin(), parameters.end(), policy.parameters),
+          "policy parameters round-trip");
+
+    message.payload.pop_back();
+    bool rejected = false;
+    try {
+        decodePolicy(message);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "truncated policy is rejected");
+
+    // Two steps, the second ending an episode
+    TrajectoryChunkBuilder builder(3, 2);
+    builder.add(State{1.0, 2.0}, 0.5, 1.5, false);
+    builder.add(State{3.0, 4.0}, -0.5, 2.5, true);
+    builder.addEpisodeReturn(4.0);
+    Message chunk_message{MessageType::TrajectoryChunk, {}};
+    builder.finish(9, chunk_message.payload);
+    check(builder.numSteps() == 0, "finish() clears the builder");
+
+    TrajectoryChunkView chunk = decodeChunk(chunk_message);
+    check(chunk.header.policy_version == 9 && chunk.header.worker_id == 3 &&
+              chunk.header.num_steps == 2 && chunk.header.observation_size == 2 &&
+              chunk.header.num_episodes == 1,
+          "chunk header round-trips");
+    const float observations[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    check(std::equal(observations, observations + 4, chunk.observations) &&
+              chunk.actions[0] == 0.5f && chunk.actions[1] == -0.5f &&
+              chunk.rewards[0] == 1.5f && chunk.rewards[1] == 2.5f &&
+              chunk.dones[0] == 0 && chunk.dones[1] == 1 && chunk.episode_returns[0] == 4.0f,
+          "chunk arrays round-trip");
+}
+
+void checkTrajectoryFile(const mjModel* model) {
+    TempFile file;
+    const double quantum = 1e-6;
+    const int frame_size = model->nq + model->nv + model->nu;
+    std::vector<std::vector<double>> expected(2);
+
+    mjData* data = mj_makeData(model);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> value(-3.0, 3.0);
+    {
+        TrajectoryRecorder recorder(file.path(), model, quantum);
+        for (int episode = 0; episode < 2; ++episode) {
+            recorder.beginEpisode();
+            for (int t = 0; t < 50 + 25 * episode; ++t) {
+                for (int i = 0; i < model->nq; ++i) {
+                    data->qpos[i] = value(rng);
+                }
+                for (int i = 0; i < model->nv; ++i) {
+                    data->qvel[i] = value(rng);
+                }
+                for (int i = 0; i < model->nu; ++i) {
+                    data->ctrl[i] = value(rng);
+                }
+                recorder.record(data);
+                expected[episode].insert(expected[episode].end(), data->qpos, data->qpos + model->nq);
+                expected[episode].insert(expected[episode].end(), data->qvel, data->qvel + model->nv);
+                expected[episode].insert(expected[episode].end(), data->ctrl, data->ctrl + model->nu);
+            }
+            recorder.endEpisode();
+        }
+    }
+    mj_deleteData(data);
+
+    TrajectoryFile trajectory(file.path());
+    check(trajectory.numEpisodes() == 2 && trajectory.frameSize() == frame_size,
+          "trajectory file has both episodes");
+    std::vector<double> frames;
+    for (int episode = 0; episode < std::min(2, trajectory.numEpisodes()); ++episode) {
+        trajectory.decodeEpisode(episode, frames);
+        bool same = frames.size() == expected[episode].size();
+        for (size_t i = 0; same && i < frames.size(); ++i) {
+            same = std::abs(frames[i] - expected[episode][i]) <= 0.5 * quantum + 1e-12;
+        }
+        check(same, "trajectory episode " + std::to_string(episode) + " decodes within the quantum");
+    }
+}
+
+void checkRunningStats() {
+    const int dim = 3;
+    const int rows = 1000;
+    std::mt19937 rng(11);
+    std::normal_distribution<double> value(5.0, 2.0);
+    std::vector<double> xs(rows * dim);
+    for (double& x : xs) {
+        x = value(rng);
+    }
+
+    // Direct two-pass moments
+    std::vector<double> mean(dim, 0.0), m2(dim, 0.0);
+    for (int r = 0; r < rows; ++r) {
+        for (int i = 0; i < dim; ++i) {
+            mean[i] += xs[r * dim + i] / rows;
+        }
+    }
+    for (int r = 0; r < rows; ++r) {
+        for (int i = 0; i < dim; ++i) {
+            m2[i] += (xs[r * dim + i] - mean[i]) * (xs[r * dim + i] - mean[i]);
+        }
+    }
+
+    // Single updates, a batch, and a merge of uneven parts must all agree
+    RunningStats sequential(dim), batched(dim), merged(dim), part(dim);
+    for (int r = 0; r < rows; ++r) {
+        sequential.update(&xs[r * dim]);
+    }
+    batched.updateBatch(xs.data(), rows);
+    merged.updateBatch(xs.data(), 137);
+    for (int r = 137; r < rows; ++r) {
+        part.update(&xs[r * dim]);
+    }
+    merged.merge(part);
+
+    for (const RunningStats* stats : {&sequential, &batched, &merged}) {
+        bool same = stats->count() == rows;
+        for (int i = 0; i < dim; ++i) {
+            same = same && near(stats->mean()[i], mean[i], 1e-12) && near(stats->m2()[i], m2[i], 1e-10);
+        }
+        check(same, "RunningStats moments match the direct computation");
+    }
+}
+
+void checkCheckpoints() {
+    TempFile file;
+
+    // ES: parameters and Adam state, so the next update continues identically
+    ESAgent::Config config;
+    config.seed = 3;
+    ESAgent saved(config);
+    std::vector<float> gradient(saved.numParameters());
+    for (size_t i = 0; i < gradient.size(); ++i) {
+        gradient[i] = std::sin(static_cast<float>(i));
+    }
+    saved.applyGradient(gradient.data());
+    saved.saveModel(file.path());
+
+    ESAgent loaded;
+    loaded.loadModel(file.path());
+    check(loaded.numParameters() == saved.numParameters() &&
+              std::equal(saved.parameters(), saved.parameters() + saved.numParameters(),
+                         loaded.parameters()),
+          "ESAgent parameters round-trip");
+    check(loaded.generation() == saved.generation(), "ESAgent generation round-trips");
+    saved.applyGradient(gradient.data());
+    loaded.applyGradient(gradient.data());
+    check(std::equal(saved.parameters(), saved.parameters() + saved.numParameters(),
+                     loaded.parameters()),
+          "ESAgent continues identically after loading");
+
+    // Tile coding: weights decide the greedy action everywhere
+    TileCodingAgent learner;
+    State state = {0.0, 0.0, 0.1, 0.0};
+    for (int t = 0; t < 200; ++t) {
+        State next = {0.01 * t, 0.1, 0.1 - 0.001 * t, -0.2};
+        learner.learn(Experience(state, learner.act(state), 1.0, next, t % 50 == 49));
+        state = next;
+    }
+    learner.saveModel(file.path());
+    TileCodingAgent restored;
+    restored.loadModel(file.path());
+    learner.setTrainingMode(false);
+    restored.setTrainingMode(false);
+    bool same = true;
+    for (int k = 0; k < 100; ++k) {
+        State probe = {-2.0 + 0.04 * k, 0.5, 0.2 - 0.004 * k, 0.1};
+        same = same && learner.act(probe) == restored.act(probe);
+    }
+    check(same, "TileCodingAgent greedy policy round-trips");
+}
+
+}  // namespace
+
+int main() {
+    try {
+        std::shared_ptr<const mjModel> model = CartPoleEnv::loadModel("mujoco/cartpole.xml");
+        checkDynamics(model.get());
+        checkRolloutProtocol();
+        checkTrajectoryFile(model.get());
+        checkRunningStats();
+        checkCheckpoints();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All framework checks passed" << std::endl;
+    return 0;
+}
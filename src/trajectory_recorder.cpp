@@ -0,0 +1,185 @@
+#include "trajectory_recorder.h"
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t getVarint(const uint8_t*& ptr, const uint8_t* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (ptr == end) {
+            throw std::runtime_error("Truncated trajectory episode");
+        }
+        uint8_t byte = *ptr++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupt varint in trajectory episode");
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+}  // namespace
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string& filepath, const mjModel* model,
+                                       double quantum)
+    : file_(filepath, std::ios::binary | std::ios::trunc),
+      nq_(model->nq), nv_(model->nv), nu_(model->nu), inv_quantum_(1.0 / quantum),
+      previous_(model->nq + model->nv + model->nu, 0), episode_frames_(0),
+      in_episode_(false), total_frames_(0) {
+    if (!file_.is_open()) {
+        throw std::runtime_error("Could not open trajectory file: " + filepath);
+    }
+
+    TrajectoryFileHeader header{};
+    header.magic = kTrajectoryMagic;
+    header.version = kTrajectoryVersion;
+    header.nq = nq_;
+    header.nv = nv_;
+    header.nu = nu_;
+    header.timestep = model->opt.timestep;
+    header.quantum = quantum;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    endEpisode();
+}
+
+void TrajectoryRecorder::beginEpisode() {
+    endEpisode();
+    std::fill(previous_.begin(), previous_.end(), 0);
+    buffer_.clear();
+    episode_frames_ = 0;
+    in_episode_ = true;
+}
+
+void TrajectoryRecorder::record(const mjData* data) {
+    if (!in_episode_) {
+        beginEpisode();
+    }
+    int64_t* previous = previous_.data();
+    encode(data->qpos, nq_, previous);
+    encode(data->qvel, nv_, previous + nq_);
+    encode(data->ctrl, nu_, previous + nq_ + nv_);
+    episode_frames_++;
+    total_frames_++;
+}
+
+void TrajectoryRecorder::endEpisode() {
+    if (!in_episode_) {
+        return;
+    }
+    in_episode_ = false;
+    if (episode_frames_ == 0) {
+        return;
+    }
+
+    TrajectoryEpisodeHeader header{kTrajectoryEpisodeMagic, episode_frames_, buffer_.size()};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size());
+    file_.flush();
+}
+
+void TrajectoryRecorder::encode(const double* values, int count, int64_t* previous) {
+    for (int i = 0; i < count; ++i) {
+        int64_t quantized = std::llround(values[i] * inv_quantum_);
+        putVarint(buffer_, zigzag(quantized - previous[i]));
+        previous[i] = quantized;
+    }
+}
+
+TrajectoryFile::TrajectoryFile(const std::string& filepath) : data_(nullptr), size_(0) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open trajectory file: " + filepath);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(TrajectoryFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error("Not a trajectory file: " + filepath);
+    }
+
+    // Frames are paged in as episodes are decoded; a recorder may still be
+    // appending, in which case only the blocks present now are visible
+    size_ = static_cast<size_t>(st.st_size);
+    void* base = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        throw std::runtime_error("Could not map trajectory file: " + filepath);
+    }
+    data_ = static_cast<const uint8_t*>(base);
+
+    std::memcpy(&header_, data_, sizeof(header_));
+    // Models have a few dozen values per frame; anything far larger is corrupt
+    const uint64_t frame_size = static_cast<uint64_t>(header_.nq) + header_.nv + header_.nu;
+    if (header_.magic != kTrajectoryMagic || header_.version != kTrajectoryVersion ||
+        frame_size == 0 || frame_size > (1u << 20)) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+        throw std::runtime_error("Unsupported trajectory file: " + filepath);
+    }
+
+    // Index complete episode blocks; a trailing partial block is ignored. Every
+    // value takes at least one varint byte, so a frame count the payload cannot
+    // hold is rejected before anything is sized from it.
+    uint64_t offset = sizeof(TrajectoryFileHeader);
+    while (offset + sizeof(TrajectoryEpisodeHeader) <= size_) {
+        TrajectoryEpisodeHeader block;
+        std::memcpy(&block, data_ + offset, sizeof(block));
+        offset += sizeof(block);
+        if (block.magic != kTrajectoryEpisodeMagic || block.payload_bytes > size_ - offset) {
+            break;
+        }
+        if (block.num_frames * frame_size > block.payload_bytes) {
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+            throw std::runtime_error("Corrupt trajectory episode in " + filepath);
+        }
+        episodes_.push_back({offset, block.payload_bytes, block.num_frames});
+        offset += block.payload_bytes;
+    }
+}
+
+TrajectoryFile::~TrajectoryFile() {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+void TrajectoryFile::decodeEpisode(int episode, std::vector<double>& frames) const {
+    const EpisodeIndex& index = episodes_.at(episode);
+    const int frame_size = frameSize();
+    const double quantum = header_.quantum;
+
+    frames.resize(static_cast<size_t>(index.num_frames) * frame_size);
+    std::vector<int64_t> previous(frame_size, 0);
+
+    const uint8_t* ptr = data_ + index.offset;
+    const uint8_t* end = ptr + index.payload_bytes;
+    double* out = frames.data();
+    for (uint32_t f = 0; f < index.num_frames; ++f) {
+        for (int i = 0; i < frame_size; ++i) {
+            previous[i] += unzigzag(getVarint(ptr, end));
+            *out++ = previous[i] * quantum;
+        }
+    }
+}
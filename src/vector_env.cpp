@@ -0,0 +1,157 @@
+#include "vector_env.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int kIdlePolls = 256;
+
+}  // namespace
+
+VectorCartPoleEnv::VectorCartPoleEnv(const mjModel* base_model, const Config& config)
+    : config_(config), observation_size_(0), episodes_(0),
+      reset_queue_(std::max(config.num_envs, 1)), running_(true), sleeping_(false) {
+    if (config_.num_envs < 1) {
+        throw std::invalid_argument("VectorCartPoleEnv needs at least one environment");
+    }
+
+    for (int i = 0; i < config_.num_envs; ++i) {
+        envs_.push_back(std::make_unique<CartPoleEnv>(base_model));
+        envs_.back()->seed(config_.seed + i);
+    }
+    observation_size_ = envs_[0]->getObservationSpaceSize();
+
+    const size_t n = envs_.size();
+    observations_.resize(n * observation_size_);
+    final_observations_.resize(n * observation_size_);
+    rewards_.resize(n);
+    dones_.resize(n);
+    truncated_.resize(n);
+
+    reset_ready_.reset(new std::atomic<bool>[n]);
+    for (size_t i = 0; i < n; ++i) {
+        reset_ready_[i].store(true, std::memory_order_relaxed);
+    }
+    if (config_.background_reset) {
+        reset_thread_ = std::thread(&VectorCartPoleEnv::resetLoop, this);
+    }
+}
+
+VectorCartPoleEnv::~VectorCartPoleEnv() {
+    running_ = false;
+    if (reset_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        wake_.notify_one();
+        reset_thread_.join();
+    }
+}
+
+const double* VectorCartPoleEnv::reset() {
+    observations();
+
+    // Observation size may have changed through env(i).setObservationSpec;
+    // rows are one stride, so every environment has to agree on it
+    observation_size_ = envs_[0]->getObservationSpaceSize();
+    for (int i = 1; i < size(); ++i) {
+        if (envs_[i]->getObservationSpaceSize() != observation_size_) {
+            throw std::invalid_argument("VectorCartPoleEnv: environment " + std::to_string(i) +
+                                        " has observation size " +
+                                        std::to_string(envs_[i]->getObservationSpaceSize()) +
+                                        ", environment 0 has " +
+                                        std::to_string(observation_size_));
+        }
+    }
+    observations_.resize(envs_.size() * observation_size_);
+    final_observations_.resize(envs_.size() * observation_size_);
+
+    for (int i = 0; i < size(); ++i) {
+        resetEnv(i);
+    }
+    std::fill(rewards_.begin(), rewards_.end(), 0.0);
+    std::fill(dones_.begin(), dones_.end(), 0);
+    std::fill(truncated_.begin(), truncated_.end(), 0);
+    return observations_.data();
+}
+
+void VectorCartPoleEnv::resetEnv(int i) {
+    CartPoleEnv& env = *envs_[i];
+    env.reset();
+    std::copy(env.observation(), env.observation() + observation_size_,
+              observations_.begin() + static_cast<size_t>(i) * observation_size_);
+}
+
+void VectorCartPoleEnv::waitForReset(int i) const {
+    while (!reset_ready_[i].load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+const double* VectorCartPoleEnv::observations() const {
+    for (int i = 0; i < size(); ++i) {
+        waitForReset(i);
+    }
+    return observations_.data();
+}
+
+void VectorCartPoleEnv::step(const Action* actions) {
+    for (int i = 0; i < size(); ++i) {
+        // Resets handed over by the previous step() have had the whole batch to finish
+        waitForReset(i);
+        CartPoleEnv& env = *envs_[i];
+        auto [state, reward, done, info] = env.step(actions[i]);
+        double* row = observations_.data() + static_cast<size_t>(i) * observation_size_;
+        std::copy(env.observation(), env.observation() + observation_size_, row);
+        rewards_[i] = reward;
+        dones_[i] = done;
+        truncated_[i] = done && info == "TimeLimit";
+        if (!done) {
+            continue;
+        }
+
+        episodes_++;
+        std::copy(row, row + observation_size_,
+                  final_observations_.begin() + static_cast<size_t>(i) * observation_size_);
+        if (!config_.background_reset) {
+            resetEnv(i);
+            continue;
+        }
+
+        // Hand over to the reset thread; nothing waits for it until row i is needed
+        reset_ready_[i].store(false, std::memory_order_relaxed);
+        reset_queue_.push(i);  // At most one entry per environment, never full
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_.notify_one();
+        }
+    }
+}
+
+void VectorCartPoleEnv::resetLoop() {
+    int index;
+    int idle_polls = 0;
+    while (running_) {
+        if (reset_queue_.pop(index)) {
+            resetEnv(index);
+            reset_ready_[index].store(true, std::memory_order_release);
+            idle_polls = 0;
+            continue;
+        }
+        // Episodes end every few steps in a large batch: poll briefly before sleeping
+        if (++idle_polls < kIdlePolls) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle_polls = 0;
+
+        // Sleep until the stepping thread hands over work; it checks sleeping_
+        // after publishing an index, so one of the two always sees the other
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true);
+        wake_.wait(lock, [&] { return !running_ || !reset_queue_.empty(); });
+        sleeping_.store(false);
+    }
+}